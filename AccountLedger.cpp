@@ -0,0 +1,87 @@
+#include "AccountLedger.hpp"
+#include "CSVReader.hpp"
+#include <exception>
+
+AccountLedger::AccountLedger(const std::vector<std::string> &_currencies)
+    : currencies(_currencies), rowSize(_currencies.size()),
+      balances((botAccount + 1) * _currencies.size(), 0) {
+  if (rowSize == 0) {
+    throw std::exception{};
+  }
+}
+
+AccountId AccountLedger::addAccount() {
+  AccountId id = static_cast<AccountId>(getAccountCount());
+  balances.resize(balances.size() + rowSize, 0);
+  return id;
+}
+
+int AccountLedger::currencyIndex(const std::string &currency) const {
+  for (std::size_t i = 0; i < currencies.size(); i++) {
+    if (currencies[i] == currency) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void AccountLedger::deposit(AccountId account, int currency, double amount) {
+  balance(account, currency) += amount;
+}
+
+double AccountLedger::getBalance(AccountId account, int currency) const {
+  return balances[account * rowSize + currency];
+}
+
+double AccountLedger::getTotal(int currency) const {
+  double total = 0;
+  for (std::size_t i = currency; i < balances.size(); i += rowSize) {
+    total += balances[i];
+  }
+  return total;
+}
+
+// Both sides are checked before either is changed
+bool AccountLedger::settle(AccountId buyer, AccountId seller, int base,
+                           int quote, double amount, double price) {
+  double cost = amount * price;
+  if (buyer != datasetAccount && balance(buyer, quote) < cost) {
+    return false;
+  }
+  if (seller != datasetAccount && balance(seller, base) < amount) {
+    return false;
+  }
+  if (buyer != datasetAccount) {
+    balance(buyer, quote) -= cost;
+    balance(buyer, base) += amount;
+  }
+  if (seller != datasetAccount) {
+    balance(seller, base) -= amount;
+    balance(seller, quote) += cost;
+  }
+  return true;
+}
+
+bool AccountLedger::settle(const OrderBookEntry &sale) {
+  if (sale.product != splitProduct) {
+    std::vector<std::string> currs = CSVReader::tokenise(sale.product, '/');
+    if (currs.size() != 2) {
+      throw std::exception{};
+    }
+    baseIndex = currencyIndex(currs[0]);
+    quoteIndex = currencyIndex(currs[1]);
+    splitProduct = sale.product;
+  }
+  if (baseIndex < 0 || quoteIndex < 0) {
+    return false;
+  }
+  if (sale.orderType == OrderBookType::bidsale) {
+    return settle(sale.accountId, sale.counterpartyId, baseIndex, quoteIndex,
+                  sale.amount, sale.price);
+  }
+  if (sale.orderType == OrderBookType::asksale) {
+    return settle(sale.counterpartyId, sale.accountId, baseIndex, quoteIndex,
+                  sale.amount, sale.price);
+  }
+  return false;
+}
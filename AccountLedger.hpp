@@ -0,0 +1,55 @@
+#pragma once
+
+#include "OrderBookEntry.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** balances of any number of accounts, indexed by AccountId. All balances
+ * sit in one contiguous array, a row of currencies per account, so settling
+ * a fill touches two rows and no map. The dataset, simuser and bot accounts
+ * always exist; the dataset account stands for the market and is never
+ * debited or credited */
+class AccountLedger {
+public:
+  /** a ledger holding these currencies */
+  explicit AccountLedger(const std::vector<std::string> &_currencies);
+
+  /** open an account with empty balances, returns its id */
+  AccountId addAccount();
+  /** number of accounts, the three fixed ones included */
+  std::size_t getAccountCount() const { return balances.size() / rowSize; }
+  /** column of a currency in every row, -1 if the ledger does not hold it.
+   * Meant for setup time, settlement passes columns around */
+  int currencyIndex(const std::string &currency) const;
+  const std::vector<std::string> &getCurrencies() const { return currencies; }
+
+  /** add to the balance of an account */
+  void deposit(AccountId account, int currency, double amount);
+  double getBalance(AccountId account, int currency) const;
+  /** sum of a currency over every account */
+  double getTotal(int currency) const;
+
+  /** the buyer pays amount * price quote currency to the seller for amount
+   * base currency. Changes nothing and returns false if an account would be
+   * overdrawn */
+  bool settle(AccountId buyer, AccountId seller, int base, int quote,
+              double amount, double price);
+  /** settle a bidsale or asksale between its account and its counterparty,
+   * as matchAsksToBids returns them */
+  bool settle(const OrderBookEntry &sale);
+
+private:
+  double &balance(AccountId account, int currency) {
+    return balances[account * rowSize + currency];
+  }
+
+  std::vector<std::string> currencies;
+  std::size_t rowSize;
+  std::vector<double> balances;
+  // The product of the previous sale and its currency columns
+  // Fills of one match share a product, so it is only split once
+  std::string splitProduct;
+  int baseIndex = -1;
+  int quoteIndex = -1;
+};
@@ -0,0 +1,195 @@
+#include "BarBuilder.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <utility>
+
+BarBuilder::BarBuilder() {}
+
+BarBuilder::BarBuilder(const std::vector<std::int64_t> &_intervals) {
+  // An interval given twice gets one series, in the order first given
+  for (std::int64_t interval : _intervals) {
+    if (std::find(intervals.begin(), intervals.end(), interval) ==
+        intervals.end()) {
+      intervals.push_back(interval);
+    }
+  }
+}
+
+// The bucket is summed up per product in one scan, then each summary is
+// folded into the bars of every interval
+void BarBuilder::addBucket(const std::string &timestamp,
+                           const std::vector<OrderBookEntry> &orders) {
+  if (intervals.empty() || orders.empty()) {
+    return;
+  }
+  std::int64_t micros;
+  try {
+    micros = Timestamp::toMicros(timestamp);
+  } catch (const std::exception &e) {
+    return;
+  }
+
+  std::vector<std::pair<const std::string *, Quote>> quotes;
+  for (const OrderBookEntry &e : orders) {
+    // The orders of a product are usually next to each other in a bucket
+    if (quotes.empty() || *quotes.back().first != e.product) {
+      bool found = false;
+      for (std::size_t i = 0; i < quotes.size(); i++) {
+        if (*quotes[i].first == e.product) {
+          std::swap(quotes[i], quotes.back());
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        quotes.emplace_back(&e.product, Quote{});
+      }
+    }
+    Quote &quote = quotes.back().second;
+    if (e.orderType == OrderBookType::bid) {
+      if (!quote.hasBid || e.price > quote.bestBid) {
+        quote.bestBid = e.price;
+      }
+      quote.hasBid = true;
+      quote.bidVolume += e.amount;
+    } else if (e.orderType == OrderBookType::ask) {
+      if (!quote.hasAsk || e.price < quote.bestAsk) {
+        quote.bestAsk = e.price;
+      }
+      quote.hasAsk = true;
+      quote.askVolume += e.amount;
+    }
+  }
+
+  for (auto const &q : quotes) {
+    std::vector<BarSeries> &productBars = series[*q.first];
+    if (productBars.empty()) {
+      productBars.resize(intervals.size());
+      for (std::size_t i = 0; i < intervals.size(); i++) {
+        productBars[i].interval = intervals[i];
+      }
+    }
+    for (BarSeries &bars : productBars) {
+      fold(bars, micros, q.second);
+    }
+  }
+}
+
+void BarBuilder::fold(BarSeries &bars, std::int64_t micros,
+                      const Quote &quote) {
+  std::int64_t offset = micros % bars.interval;
+  // Bars before the epoch still start on a multiple of the interval
+  std::int64_t start = micros - (offset < 0 ? offset + bars.interval : offset);
+  if (bars.start.empty() || bars.start.back() != start) {
+    appendBar(bars, start);
+  }
+  std::size_t i = bars.size() - 1;
+  if (quote.hasBid) {
+    update(bars.bidOpen[i], bars.bidHigh[i], bars.bidLow[i], bars.bidClose[i],
+           quote.bestBid);
+    bars.bidVolume[i] += quote.bidVolume;
+  }
+  if (quote.hasAsk) {
+    update(bars.askOpen[i], bars.askHigh[i], bars.askLow[i], bars.askClose[i],
+           quote.bestAsk);
+    bars.askVolume[i] += quote.askVolume;
+  }
+  if (quote.hasBid && quote.hasAsk) {
+    update(bars.open[i], bars.high[i], bars.low[i], bars.close[i],
+           (quote.bestBid + quote.bestAsk) / 2);
+  }
+  bars.volume[i] += quote.bidVolume + quote.askVolume;
+  bars.buckets[i]++;
+}
+
+void BarBuilder::appendBar(BarSeries &bars, std::int64_t start) {
+  double none = std::numeric_limits<double>::quiet_NaN();
+  bars.start.push_back(start);
+  for (std::vector<double> *column :
+       {&bars.open, &bars.high, &bars.low, &bars.close, &bars.bidOpen,
+        &bars.bidHigh, &bars.bidLow, &bars.bidClose, &bars.askOpen,
+        &bars.askHigh, &bars.askLow, &bars.askClose}) {
+    column->push_back(none);
+  }
+  bars.volume.push_back(0);
+  bars.bidVolume.push_back(0);
+  bars.askVolume.push_back(0);
+  bars.buckets.push_back(0);
+}
+
+// The first price of a bar opens it, NaN marks a bar without one yet
+void BarBuilder::update(double &open, double &high, double &low,
+                        double &close, double price) {
+  if (std::isnan(open)) {
+    open = high = low = price;
+  }
+  if (price > high) {
+    high = price;
+  }
+  if (price < low) {
+    low = price;
+  }
+  close = price;
+}
+
+const BarSeries *BarBuilder::find(const std::string &product,
+                                  std::int64_t interval) const {
+  auto productBars = series.find(product);
+  if (productBars == series.end()) {
+    return nullptr;
+  }
+  for (const BarSeries &bars : productBars->second) {
+    if (bars.interval == interval) {
+      return &bars;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<std::string> BarBuilder::getProducts() const {
+  std::vector<std::string> products;
+  for (auto const &s : series) {
+    products.push_back(s.first);
+  }
+  return products;
+}
+
+std::size_t BarBuilder::getMemoryUsage() const {
+  std::size_t bytes = 0;
+  for (auto const &s : series) {
+    for (const BarSeries &bars : s.second) {
+      // 15 double columns, the start column and the bucket counts
+      bytes += bars.start.capacity() * sizeof(std::int64_t) +
+               bars.open.capacity() * sizeof(double) * 15 +
+               bars.buckets.capacity() * sizeof(std::uint32_t);
+    }
+  }
+  return bytes;
+}
+
+std::int64_t BarBuilder::parseInterval(const std::string &text) {
+  std::size_t digits = 0;
+  long long count = std::stoll(text, &digits);
+  std::string unit = text.substr(digits);
+  std::int64_t micros = 0;
+  if (unit == "us") {
+    micros = 1;
+  } else if (unit == "ms") {
+    micros = 1000;
+  } else if (unit == "s") {
+    micros = 1000000;
+  } else if (unit == "m") {
+    micros = 60000000;
+  } else if (unit == "h") {
+    micros = 3600000000LL;
+  }
+  // A count whose microseconds do not fit in 64 bits is as bad as no unit
+  if (count <= 0 || micros == 0 ||
+      count > std::numeric_limits<std::int64_t>::max() / micros) {
+    throw std::exception{};
+  }
+  return count * micros;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "OrderBookEntry.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/** bars of one product at one interval, stored column by column: row i of
+ * every column is bar i. Only intervals with orders get a bar. Prices of a
+ * side that had no orders in a bar are NaN */
+struct BarSeries {
+  /** bar length in microseconds */
+  std::int64_t interval = 0;
+  /** start of each bar, microseconds since the epoch, aligned on interval */
+  std::vector<std::int64_t> start;
+  /** OHLC of the mid price between best bid and best ask */
+  std::vector<double> open;
+  std::vector<double> high;
+  std::vector<double> low;
+  std::vector<double> close;
+  /** amount of every order of both sides */
+  std::vector<double> volume;
+  /** OHLC of the best bid, and amount of every bid */
+  std::vector<double> bidOpen;
+  std::vector<double> bidHigh;
+  std::vector<double> bidLow;
+  std::vector<double> bidClose;
+  std::vector<double> bidVolume;
+  /** OHLC of the best ask, and amount of every ask */
+  std::vector<double> askOpen;
+  std::vector<double> askHigh;
+  std::vector<double> askLow;
+  std::vector<double> askClose;
+  std::vector<double> askVolume;
+  /** number of timestamp buckets folded into each bar */
+  std::vector<std::uint32_t> buckets;
+
+  std::size_t size() const { return start.size(); }
+};
+
+/** aggregates timestamp buckets into OHLCV and bid/ask bars of every product,
+ * at any number of intervals in the same pass. Buckets have to come in time
+ * order, as the book loads them */
+class BarBuilder {
+public:
+  BarBuilder();
+  /** build bars of these lengths, in microseconds, once per distinct length */
+  explicit BarBuilder(const std::vector<std::int64_t> &_intervals);
+
+  /** fold the orders of one timestamp into the bars */
+  void addBucket(const std::string &timestamp,
+                 const std::vector<OrderBookEntry> &orders);
+
+  /** bars of a product at one of the intervals, nullptr if there are none */
+  const BarSeries *find(const std::string &product,
+                        std::int64_t interval) const;
+  /** every product with bars */
+  std::vector<std::string> getProducts() const;
+  const std::vector<std::int64_t> &getIntervals() const { return intervals; }
+  bool empty() const { return intervals.empty(); }
+  /** approximate heap bytes held by the bars */
+  std::size_t getMemoryUsage() const;
+
+  /** interval length of a text like "500ms", "1s", "5m" or "1h", throws if
+   * it cannot be read or does not fit in 64 bits of microseconds */
+  static std::int64_t parseInterval(const std::string &text);
+
+private:
+  /** top of book and volumes of one product in one bucket */
+  struct Quote {
+    bool hasBid = false;
+    bool hasAsk = false;
+    double bestBid = 0;
+    double bestAsk = 0;
+    double bidVolume = 0;
+    double askVolume = 0;
+  };
+
+  static void fold(BarSeries &bars, std::int64_t micros, const Quote &quote);
+  static void appendBar(BarSeries &bars, std::int64_t start);
+  static void update(double &open, double &high, double &low, double &close,
+                     double price);
+
+  std::vector<std::int64_t> intervals;
+  // One series per interval, in the order of intervals
+  std::map<std::string, std::vector<BarSeries>> series;
+};
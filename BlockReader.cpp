@@ -0,0 +1,198 @@
+#include "BlockReader.hpp"
+#include <cstring>
+#include <iostream>
+
+#ifdef MERKEL_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+// State of the decompressor of the file's format, none for plain text
+struct BlockReader::Decoder {
+#ifdef MERKEL_WITH_ZLIB
+  z_stream zlib{};
+  bool zlibReady = false;
+  // Between the header and the end of a gzip member
+  bool zlibInMember = false;
+#endif
+
+  ~Decoder() {
+#ifdef MERKEL_WITH_ZLIB
+    if (zlibReady) {
+      inflateEnd(&zlib);
+    }
+#endif
+  }
+};
+
+BlockReader::BlockReader(const std::string &path, std::size_t _blockSize)
+    : blockSize(_blockSize == 0 ? 1 : _blockSize), decoder(new Decoder),
+      input(1 << 16) {
+  file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return;
+  }
+  unsigned char magic[4] = {0, 0, 0, 0};
+  std::size_t magicSize = std::fread(magic, 1, sizeof(magic), file);
+  std::rewind(file);
+  if (magicSize >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    format = Format::gzip;
+  } else if (magicSize == 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+             magic[2] == 0x2f && magic[3] == 0xfd) {
+    format = Format::zstd;
+  }
+
+  bool supported = format == Format::plain;
+#ifdef MERKEL_WITH_ZLIB
+  if (format == Format::gzip) {
+    // 15 + 32: the largest window, with the gzip or zlib header detected
+    supported = inflateInit2(&decoder->zlib, 15 + 32) == Z_OK;
+    decoder->zlibReady = supported;
+  }
+#endif
+  if (!supported) {
+    std::cout << "BlockReader " << path << " is " << formatName(format)
+              << " compressed, which this build cannot read" << std::endl;
+    std::fclose(file);
+    file = nullptr;
+    return;
+  }
+  producer = std::thread{&BlockReader::produce, this};
+}
+
+BlockReader::~BlockReader() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  changed.notify_all();
+  if (producer.joinable()) {
+    producer.join();
+  }
+  if (file != nullptr) {
+    std::fclose(file);
+  }
+}
+
+const char *BlockReader::formatName(Format format) {
+  switch (format) {
+  case Format::gzip:
+    return "gzip";
+  case Format::zstd:
+    return "zstd";
+  default:
+    return "plain";
+  }
+}
+
+// Blocks are filled in turn, each one once the consumer has handed it back
+void BlockReader::produce() {
+  int next = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      changed.wait(lock, [&] { return !full[next] || stopping; });
+      if (stopping) {
+        return;
+      }
+    }
+    // The consumer leaves a block alone until it is marked full
+    bool more = fill(blocks[next]);
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      full[next] = !blocks[next].empty();
+      finished = !more;
+    }
+    changed.notify_all();
+    if (!more) {
+      return;
+    }
+    next ^= 1;
+  }
+}
+
+// Fills a block with up to blockSize bytes of text, false once there are
+// none left
+bool BlockReader::fill(std::vector<char> &block) {
+  block.resize(blockSize);
+  std::size_t size = 0;
+  if (format == Format::plain) {
+    size = std::fread(block.data(), 1, blockSize, file);
+  }
+#ifdef MERKEL_WITH_ZLIB
+  if (format == Format::gzip) {
+    z_stream &z = decoder->zlib;
+    z.next_out = reinterpret_cast<Bytef *>(block.data());
+    z.avail_out = static_cast<uInt>(blockSize);
+    while (z.avail_out > 0) {
+      if (z.avail_in == 0) {
+        std::size_t read = std::fread(input.data(), 1, input.size(), file);
+        if (read == 0) {
+          // The file ending inside a member means it was cut short
+          if (decoder->zlibInMember) {
+            error = true;
+          }
+          break;
+        }
+        z.next_in = reinterpret_cast<Bytef *>(input.data());
+        z.avail_in = static_cast<uInt>(read);
+      }
+      decoder->zlibInMember = true;
+      int status = inflate(&z, Z_NO_FLUSH);
+      if (status == Z_STREAM_END) {
+        // A gzip file can hold several members one after the other
+        inflateReset(&z);
+        decoder->zlibInMember = false;
+      } else if (status != Z_OK) {
+        error = true;
+        break;
+      }
+    }
+    size = blockSize - z.avail_out;
+  }
+#endif
+  block.resize(size);
+  return size > 0 && !error;
+}
+
+// Hands the block read so far back to the producer and waits for the next
+bool BlockReader::nextBlock() {
+  std::unique_lock<std::mutex> lock{mutex};
+  if (current >= 0) {
+    full[current] = false;
+    changed.notify_all();
+    current ^= 1;
+  } else {
+    current = 0;
+  }
+  changed.wait(lock, [&] { return full[current] || finished; });
+  position = 0;
+  return full[current];
+}
+
+bool BlockReader::getline(std::string &line) {
+  line.clear();
+  if (file == nullptr || ended) {
+    return false;
+  }
+  while (true) {
+    if (current < 0 || position == blocks[current].size()) {
+      if (!nextBlock()) {
+        ended = true;
+        // The last line may have no line break
+        return !line.empty();
+      }
+    }
+    const char *data = blocks[current].data();
+    const char *begin = data + position;
+    std::size_t left = blocks[current].size() - position;
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(begin, '\n', left));
+    if (lineEnd != nullptr) {
+      line.append(begin, lineEnd);
+      position = lineEnd - data + 1;
+      return true;
+    }
+    line.append(begin, left);
+    position = blocks[current].size();
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** reads a text file line by line, plain or gzip compressed, the format
+ * being told apart by the file's first bytes. A thread of its own reads and
+ * decompresses the file a block at a time into one of two buffers, while
+ * the caller takes lines out of the other one, so decompression overlaps
+ * parsing and nothing is written to disk.
+ * gzip needs a build with -DMERKEL_WITH_ZLIB (and -lz). zstd files are
+ * recognised so they can be refused, not read */
+class BlockReader {
+public:
+  enum class Format { plain, gzip, zstd };
+
+  /** open a file, decompressed blocks are `_blockSize` bytes at most */
+  explicit BlockReader(const std::string &path,
+                       std::size_t _blockSize = 1 << 20);
+  ~BlockReader();
+  BlockReader(const BlockReader &) = delete;
+  BlockReader &operator=(const BlockReader &) = delete;
+
+  /** false if the file cannot be opened, or is compressed in a format this
+   * build cannot read */
+  bool isOpen() const { return file != nullptr; }
+  Format getFormat() const { return format; }
+  /** the next line without its line break, like std::getline. False once
+   * every line has been read */
+  bool getline(std::string &line);
+  /** true if the compressed data turned out to be corrupt or truncated */
+  bool failed() const { return error; }
+
+  static const char *formatName(Format format);
+
+private:
+  struct Decoder;
+
+  void produce();
+  bool fill(std::vector<char> &block);
+  bool nextBlock();
+
+  std::FILE *file = nullptr;
+  Format format = Format::plain;
+  std::size_t blockSize;
+  std::unique_ptr<Decoder> decoder;
+  // Compressed bytes read from the file, waiting to be decompressed
+  std::vector<char> input;
+
+  // The producer fills a block while the consumer reads the other one
+  std::vector<char> blocks[2];
+  bool full[2] = {false, false};
+  bool finished = false;
+  bool stopping = false;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::thread producer;
+  std::atomic<bool> error{false};
+
+  // Consumer side: the block being read, -1 before the first one
+  int current = -1;
+  std::size_t position = 0;
+  bool ended = false;
+};
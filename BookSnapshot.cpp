@@ -0,0 +1,55 @@
+#include "BookSnapshot.hpp"
+
+BookSnapshot::BookSnapshot()
+    : maxAsk(0), minAsk(0), maxBid(0), minBid(0), askCount(0), bidCount(0) {}
+
+std::map<std::string, BookSnapshot>
+BookSnapshot::buildAll(const std::vector<OrderBookEntry> &orders) {
+  std::map<std::string, BookSnapshot> snapshots;
+  for (const OrderBookEntry &e : orders) {
+    snapshots[e.product].apply(e);
+  }
+  return snapshots;
+}
+
+void BookSnapshot::apply(const OrderBookEntry &order) {
+  if (order.orderType == OrderBookType::ask) {
+    if (askCount == 0 || order.price > maxAsk)
+      maxAsk = order.price;
+    if (askCount == 0 || order.price < minAsk)
+      minAsk = order.price;
+    askCount++;
+    addLevel(askDepth, order.price, order.amount, true);
+  }
+  if (order.orderType == OrderBookType::bid) {
+    if (bidCount == 0 || order.price > maxBid)
+      maxBid = order.price;
+    if (bidCount == 0 || order.price < minBid)
+      minBid = order.price;
+    bidCount++;
+    addLevel(bidDepth, order.price, order.amount, false);
+  }
+}
+
+// Levels are kept sorted best first and truncated to depthLevels.
+// A level that falls off the end can never come back, since the levels kept
+// in front of it only ever get replaced by better ones.
+void BookSnapshot::addLevel(std::vector<DepthLevel> &levels, double price,
+                            double amount, bool ascending) {
+  std::vector<DepthLevel>::iterator it = levels.begin();
+  while (it != levels.end() &&
+         (ascending ? it->price < price : it->price > price)) {
+    ++it;
+  }
+  if (it != levels.end() && it->price == price) {
+    it->amount += amount;
+    return;
+  }
+  if (it == levels.end() && levels.size() >= depthLevels) {
+    return;
+  }
+  levels.insert(it, DepthLevel{price, amount});
+  if (levels.size() > depthLevels) {
+    levels.pop_back();
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "OrderBookEntry.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+/** one aggregated price level: every order resting at this price */
+struct DepthLevel {
+  double price;
+  double amount;
+};
+
+/** cached top-of-book and aggregated depth of one product at one timestamp */
+class BookSnapshot {
+public:
+  /** number of aggregated price levels kept on each side of the book */
+  static const unsigned int depthLevels = 10;
+
+  BookSnapshot();
+  /** build the snapshots of every product in a sealed timestamp bucket */
+  static std::map<std::string, BookSnapshot>
+  buildAll(const std::vector<OrderBookEntry> &orders);
+  /** fold a single order into the snapshot, used for inserted orders */
+  void apply(const OrderBookEntry &order);
+
+  bool hasAsks() const { return askCount > 0; }
+  bool hasBids() const { return bidCount > 0; }
+
+  double maxAsk;
+  double minAsk;
+  double maxBid;
+  double minBid;
+  unsigned int askCount;
+  unsigned int bidCount;
+  /** best levels first: asks ascending, bids descending by price */
+  std::vector<DepthLevel> askDepth;
+  std::vector<DepthLevel> bidDepth;
+
+private:
+  static void addLevel(std::vector<DepthLevel> &levels, double price,
+                       double amount, bool ascending);
+};
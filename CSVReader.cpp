@@ -1,25 +1,30 @@
 #include "CSVReader.hpp"
-#include <fstream>
+#include "BlockReader.hpp"
 #include <iostream>
 #include <map>
+#include <utility>
 
 CSVReader::CSVReader() {}
 
 std::vector<OrderBookEntry> CSVReader::readCSV(std::string csvFilename) {
   std::vector<OrderBookEntry> entries;
 
-  std::ifstream csvFile{csvFilename};
+  // Compressed files are decompressed on the fly, on a thread of their own
+  BlockReader csvFile{csvFilename};
   std::string line;
 
-  if (csvFile.is_open()) {
-    while (std::getline(csvFile, line)) {
+  if (csvFile.isOpen()) {
+    while (csvFile.getline(line)) {
       try {
-        OrderBookEntry obe = stringsToOBE(tokenise(line, ','));
-        entries.push_back(obe);
+        entries.push_back(stringsToOBE(tokenise(line, ',')));
       } catch (const std::exception &e) {
         std::cout << "CSVReader::readCSV bad data" << std::endl;
       }
     } // end of while
+    if (csvFile.failed()) {
+      std::cout << "CSVReader::readCSV corrupt data in " << csvFilename
+                << std::endl;
+    }
   }
 
   std::cout << "CSVReader::readCSV read " << entries.size() << " entries"
@@ -31,63 +36,82 @@ std::map<std::string, std::vector<OrderBookEntry>>
 CSVReader::readCSVMap(std::string csvFilename) {
   std::map<std::string, std::vector<OrderBookEntry>> entries;
 
-  std::ifstream csvFile{csvFilename};
+  BlockReader csvFile{csvFilename};
   std::string line;
 
-  if (csvFile.is_open()) {
+  if (csvFile.isOpen()) {
     std::string currentTimestamp = "";
     std::vector<OrderBookEntry> timestampEntries;
 
-    while (std::getline(csvFile, line)) {
+    while (csvFile.getline(line)) {
       try {
-        std::vector<std::string> tokens = tokenise(line, ',');
-        OrderBookEntry obe = stringsToOBE(tokens);
-        // First timestamp or Same timestamp
-        if (currentTimestamp == "" || currentTimestamp == tokens[0]) {
-          timestampEntries.push_back(obe);
-          currentTimestamp = tokens[0];
+        OrderBookEntry obe = stringsToOBE(tokenise(line, ','));
+        // New timestamp: the finished bucket is moved into the map
+        if (obe.timestamp != currentTimestamp && !timestampEntries.empty()) {
+          std::size_t bucketSize = timestampEntries.size();
+          sealBucket(entries, currentTimestamp, timestampEntries);
+          timestampEntries.reserve(bucketSize);
         }
-        // New timestamp
-        if (currentTimestamp != tokens[0] && currentTimestamp != "") {
-          // New OBE vector
-          entries.insert(std::pair<std::string, std::vector<OrderBookEntry>>(
-              tokens[0], timestampEntries));
-          timestampEntries.clear();
-          timestampEntries.push_back(obe);
-          currentTimestamp = tokens[0];
+        // First entry of a bucket
+        if (timestampEntries.empty()) {
+          currentTimestamp = obe.timestamp;
         }
+        timestampEntries.push_back(std::move(obe));
       } catch (const std::exception &e) {
         std::cout << "CSVReader::readCSV bad data" << std::endl;
       }
     } // end of while
+    // The last bucket has no following timestamp to seal it
+    if (!timestampEntries.empty()) {
+      sealBucket(entries, currentTimestamp, timestampEntries);
+    }
+    if (csvFile.failed()) {
+      std::cout << "CSVReader::readCSV corrupt data in " << csvFilename
+                << std::endl;
+    }
   }
   std::cout << "CSVReader::readCSV read " << entries.size() << " entries"
             << std::endl;
   return entries;
 }
 
-std::vector<std::string> CSVReader::tokenise(std::string csvLine,
+void CSVReader::sealBucket(
+    std::map<std::string, std::vector<OrderBookEntry>> &entries,
+    const std::string &timestamp, std::vector<OrderBookEntry> &bucket) {
+  std::vector<OrderBookEntry> &stored = entries[timestamp];
+  if (stored.empty()) {
+    stored = std::move(bucket);
+  } else {
+    // The timestamp was seen before, out of order: append to its bucket
+    stored.insert(stored.end(), std::make_move_iterator(bucket.begin()),
+                  std::make_move_iterator(bucket.end()));
+  }
+  bucket.clear();
+}
+
+std::vector<std::string> CSVReader::tokenise(const std::string &csvLine,
                                              char separator) {
   std::vector<std::string> tokens;
+  // A day file line has 5 tokens, room for them is made at once
+  tokens.reserve(8);
   signed int start, end;
-  std::string token;
   start = csvLine.find_first_not_of(separator, 0);
   do {
     end = csvLine.find_first_of(separator, start);
     if (start == csvLine.length() || start == end)
       break;
+    // Each token is moved into the vector, not copied
     if (end >= 0)
-      token = csvLine.substr(start, end - start);
+      tokens.push_back(csvLine.substr(start, end - start));
     else
-      token = csvLine.substr(start, csvLine.length() - start);
-    tokens.push_back(token);
+      tokens.push_back(csvLine.substr(start, csvLine.length() - start));
     start = end + 1;
   } while (end > 0);
 
   return tokens;
 }
 
-OrderBookEntry CSVReader::stringsToOBE(std::vector<std::string> tokens) {
+OrderBookEntry CSVReader::stringsToOBE(std::vector<std::string> &&tokens) {
   double price, amount;
 
   if (tokens.size() != 5) // bad
@@ -107,14 +131,13 @@ OrderBookEntry CSVReader::stringsToOBE(std::vector<std::string> tokens) {
     throw;
   }
 
-  OrderBookEntry obe{price, amount, tokens[0], tokens[1],
-                     OrderBookEntry::stringToOrderBookType(tokens[2])};
-
-  return obe;
+  return OrderBookEntry{price, amount, std::move(tokens[0]),
+                        std::move(tokens[1]),
+                        OrderBookEntry::stringToOrderBookType(tokens[2])};
 }
 
-OrderBookEntry CSVReader::stringsToOBE(std::string priceString,
-                                       std::string amountString,
+OrderBookEntry CSVReader::stringsToOBE(const std::string &priceString,
+                                       const std::string &amountString,
                                        std::string timestamp,
                                        std::string product,
                                        OrderBookType orderType) {
@@ -129,7 +152,6 @@ OrderBookEntry CSVReader::stringsToOBE(std::string priceString,
               << std::endl;
     throw;
   }
-  OrderBookEntry obe{price, amount, timestamp, product, orderType};
-
-  return obe;
+  return OrderBookEntry{price, amount, std::move(timestamp), std::move(product),
+                        orderType};
 }
@@ -13,12 +13,21 @@ public:
   static std::map<std::string, std::vector<OrderBookEntry>>
   readCSVMap(std::string csvFile);
   /** split the csv line based on a separator character */
-  static std::vector<std::string> tokenise(std::string csvLine, char separator);
-  /** transform tokenized strings into an obe  */
-  static OrderBookEntry stringsToOBE(std::string price, std::string amount,
+  static std::vector<std::string> tokenise(const std::string &csvLine,
+                                           char separator);
+  /** transform tokenized strings into an obe, timestamp and product are moved
+   * into it */
+  static OrderBookEntry stringsToOBE(const std::string &price,
+                                     const std::string &amount,
                                      std::string timestamp, std::string product,
                                      OrderBookType OrderBookType);
 
 private:
-  static OrderBookEntry stringsToOBE(std::vector<std::string> strings);
+  /** the tokens of a line, the timestamp and product are moved into the
+   * entry */
+  static OrderBookEntry stringsToOBE(std::vector<std::string> &&tokens);
+  /** move a finished timestamp bucket into the map */
+  static void
+  sealBucket(std::map<std::string, std::vector<OrderBookEntry>> &entries,
+             const std::string &timestamp, std::vector<OrderBookEntry> &bucket);
 };
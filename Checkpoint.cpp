@@ -0,0 +1,84 @@
+#include "Checkpoint.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+void CheckpointWriter::write(const std::string &value) {
+  write(static_cast<std::uint32_t>(value.size()));
+  buffer.append(value);
+}
+
+void CheckpointWriter::write(const std::vector<double> &values) {
+  write(static_cast<std::uint32_t>(values.size()));
+  buffer.append(reinterpret_cast<const char *>(values.data()),
+                values.size() * sizeof(double));
+}
+
+void CheckpointWriter::write(const std::deque<double> &values) {
+  write(static_cast<std::uint32_t>(values.size()));
+  for (double value : values) {
+    write(value);
+  }
+}
+
+bool CheckpointWriter::saveTo(const std::string &path) const {
+  // Written next to the target and renamed, so a crash never leaves half a checkpoint
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+    file.write(buffer.data(), buffer.size());
+    if (!file) {
+      return false;
+    }
+  }
+  return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool CheckpointReader::loadFrom(const std::string &path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file.is_open()) {
+    return false;
+  }
+  buffer.assign(std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+  position = 0;
+  return true;
+}
+
+const char *CheckpointReader::take(std::size_t size) {
+  if (position + size > buffer.size()) {
+    throw std::exception{};
+  }
+  const char *data = buffer.data() + position;
+  position += size;
+  return data;
+}
+
+void CheckpointReader::read(std::string &value) {
+  std::uint32_t size;
+  read(size);
+  value.assign(take(size), size);
+}
+
+void CheckpointReader::read(std::vector<double> &values) {
+  std::uint32_t size;
+  read(size);
+  // A corrupt size must not allocate more than the checkpoint holds
+  if (std::size_t{size} * sizeof(double) > buffer.size() - position) {
+    throw std::exception{};
+  }
+  values.resize(size);
+  std::memcpy(values.data(), take(size * sizeof(double)),
+              size * sizeof(double));
+}
+
+void CheckpointReader::read(std::deque<double> &values) {
+  std::uint32_t size;
+  read(size);
+  values.clear();
+  for (std::uint32_t i = 0; i < size; i++) {
+    double value;
+    read(value);
+    values.push_back(value);
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/** position of a replay: every bid up to and including this timestamp of
+ * this catalog day (0 for a single file) has been processed */
+struct ReplayCursor {
+  std::uint32_t day = 0;
+  std::string timestamp;
+};
+
+/** builds a binary checkpoint in memory and writes it out in one go */
+class CheckpointWriter {
+public:
+  template <typename T> void write(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values are written as bytes");
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  void write(const std::string &value);
+  void write(const std::vector<double> &values);
+  void write(const std::deque<double> &values);
+  /** write the whole checkpoint to a file, returns false on failure */
+  bool saveTo(const std::string &path) const;
+
+private:
+  std::string buffer;
+};
+
+/** reads back what a CheckpointWriter wrote, in the same order.
+ * Reading past the end of the data throws. */
+class CheckpointReader {
+public:
+  /** read a whole checkpoint file, returns false if it cannot be read */
+  bool loadFrom(const std::string &path);
+  template <typename T> void read(T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values are read as bytes");
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+  }
+  void read(std::string &value);
+  void read(std::vector<double> &values);
+  void read(std::deque<double> &values);
+
+private:
+  const char *take(std::size_t size);
+
+  std::string buffer;
+  std::size_t position = 0;
+};
+
+/** identifies checkpoint files and their layout version */
+const std::uint32_t checkpointMagic = 0x4d4b434b;
+const std::uint32_t checkpointVersion = 2;
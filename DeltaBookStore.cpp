@@ -0,0 +1,175 @@
+#include "DeltaBookStore.hpp"
+#include "MemoryReport.hpp"
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <utility>
+
+namespace {
+constexpr std::size_t noPosition = std::numeric_limits<std::size_t>::max();
+}
+
+DeltaBookStore::DeltaBookStore(unsigned int _keyframeInterval)
+    : keyframeInterval(_keyframeInterval == 0 ? 1 : _keyframeInterval),
+      currentPosition(noPosition) {}
+
+// Orders of the same product, type and price sit at the same level
+bool DeltaBookStore::lessByLevel(const CompactOrder &o1,
+                                 const CompactOrder &o2) {
+  if (o1.product != o2.product) {
+    return o1.product < o2.product;
+  }
+  if (o1.orderType != o2.orderType) {
+    return o1.orderType < o2.orderType;
+  }
+  return o1.price < o2.price;
+}
+
+bool DeltaBookStore::lessByOrder(const CompactOrder &o1,
+                                 const CompactOrder &o2) {
+  if (lessByLevel(o1, o2)) {
+    return true;
+  }
+  if (lessByLevel(o2, o1)) {
+    return false;
+  }
+  return o1.amount < o2.amount;
+}
+
+std::uint16_t DeltaBookStore::productIndex(const std::string &product) {
+  for (std::size_t i = 0; i < products.size(); i++) {
+    if (products[i] == product) {
+      return static_cast<std::uint16_t>(i);
+    }
+  }
+  products.push_back(product);
+  return static_cast<std::uint16_t>(products.size() - 1);
+}
+
+void DeltaBookStore::append(const std::string &timestamp,
+                            const std::vector<OrderBookEntry> &orders) {
+  if (!timestamps.empty() && timestamp <= timestamps.back()) {
+    throw std::exception{};
+  }
+  std::vector<CompactOrder> bucket;
+  bucket.reserve(orders.size());
+  for (const OrderBookEntry &e : orders) {
+    bucket.push_back(
+        CompactOrder{e.price, e.amount, productIndex(e.product), e.orderType});
+  }
+  std::sort(bucket.begin(), bucket.end(), lessByOrder);
+
+  std::size_t position = timestamps.size();
+  timestamps.push_back(timestamp);
+  if (position % keyframeInterval == 0) {
+    keyframes.push_back(bucket);
+    deltas.emplace_back();
+  } else {
+    deltas.push_back(diff(last, bucket));
+  }
+  last = std::move(bucket);
+}
+
+// Both buckets are sorted, so one merge pass over them finds the levels
+// that appeared, disappeared or changed amount
+DeltaBookStore::Delta
+DeltaBookStore::diff(const std::vector<CompactOrder> &from,
+                     const std::vector<CompactOrder> &to) {
+  Delta delta;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < from.size() || j < to.size()) {
+    if (j == to.size() || (i < from.size() && lessByLevel(from[i], to[j]))) {
+      delta.removed.push_back(static_cast<std::uint32_t>(i++));
+    } else if (i == from.size() || lessByLevel(to[j], from[i])) {
+      delta.added.push_back(to[j++]);
+    } else {
+      if (from[i].amount != to[j].amount) {
+        delta.changed.push_back(
+            Change{static_cast<std::uint32_t>(i), to[j].amount});
+      }
+      i++;
+      j++;
+    }
+  }
+  delta.removed.shrink_to_fit();
+  delta.changed.shrink_to_fit();
+  delta.added.shrink_to_fit();
+  return delta;
+}
+
+void DeltaBookStore::apply(const std::vector<CompactOrder> &from,
+                           const Delta &delta, std::vector<CompactOrder> &to) {
+  to.clear();
+  to.reserve(from.size() - delta.removed.size() + delta.added.size());
+  std::size_t r = 0;
+  std::size_t c = 0;
+  std::size_t a = 0;
+  for (std::size_t i = 0; i < from.size(); i++) {
+    if (r < delta.removed.size() && delta.removed[r] == i) {
+      r++;
+      continue;
+    }
+    CompactOrder order = from[i];
+    if (c < delta.changed.size() && delta.changed[c].index == i) {
+      order.amount = delta.changed[c++].amount;
+    }
+    while (a < delta.added.size() && lessByOrder(delta.added[a], order)) {
+      to.push_back(delta.added[a++]);
+    }
+    to.push_back(order);
+  }
+  to.insert(to.end(), delta.added.begin() + a, delta.added.end());
+}
+
+// Starts from the bucket rebuilt last when it lies between the keyframe and
+// the position, from the keyframe otherwise
+void DeltaBookStore::rebuild(std::size_t position) {
+  std::size_t keyframe = position / keyframeInterval * keyframeInterval;
+  if (currentPosition == noPosition || currentPosition > position ||
+      currentPosition < keyframe) {
+    current = keyframes[position / keyframeInterval];
+    currentPosition = keyframe;
+  }
+  while (currentPosition < position) {
+    currentPosition++;
+    apply(current, deltas[currentPosition], scratch);
+    std::swap(current, scratch);
+    stepsApplied++;
+  }
+}
+
+std::vector<OrderBookEntry>
+DeltaBookStore::getBucket(const std::string &timestamp) {
+  std::vector<OrderBookEntry> orders;
+  auto found =
+      std::lower_bound(timestamps.begin(), timestamps.end(), timestamp);
+  if (found == timestamps.end() || *found != timestamp) {
+    return orders;
+  }
+  rebuild(found - timestamps.begin());
+  orders.reserve(current.size());
+  for (const CompactOrder &o : current) {
+    orders.emplace_back(o.price, o.amount, timestamp, products[o.product],
+                        o.orderType);
+  }
+  return orders;
+}
+
+std::size_t DeltaBookStore::getMemoryUsage() const {
+  std::size_t bytes = timestamps.capacity() * sizeof(std::string) +
+                      keyframes.capacity() * sizeof(keyframes[0]) +
+                      deltas.capacity() * sizeof(Delta);
+  for (const std::string &t : timestamps) {
+    bytes += MemoryReport::stringBytes(t);
+  }
+  for (const std::vector<CompactOrder> &k : keyframes) {
+    bytes += k.capacity() * sizeof(CompactOrder);
+  }
+  for (const Delta &d : deltas) {
+    bytes += d.removed.capacity() * sizeof(std::uint32_t) +
+             d.changed.capacity() * sizeof(Change) +
+             d.added.capacity() * sizeof(CompactOrder);
+  }
+  return bytes;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "OrderBookEntry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** an order without its timestamp, the product as an index into the
+ * store's products */
+struct CompactOrder {
+  double price;
+  double amount;
+  std::uint16_t product;
+  OrderBookType orderType;
+};
+
+/** timestamp buckets kept as a full keyframe every few timestamps and, in
+ * between, the difference from one bucket to the next: orders added,
+ * removed, and orders whose amount changed at the same price. Any bucket is
+ * rebuilt by applying the differences after its keyframe, so reading one
+ * costs at most keyframeInterval - 1 steps, and reading them in order costs
+ * one step each. The differences only pay off when consecutive buckets
+ * share orders. Buckets come back grouped by product, then ordered by type,
+ * price and amount, rather than in the order they were added */
+class DeltaBookStore {
+public:
+  /** a keyframe every `_keyframeInterval` timestamps, 1 keeps every bucket
+   * in full */
+  explicit DeltaBookStore(unsigned int _keyframeInterval = 64);
+
+  /** add the orders of a timestamp after every one added so far, throws if
+   * it comes before them */
+  void append(const std::string &timestamp,
+              const std::vector<OrderBookEntry> &orders);
+  /** orders of a timestamp, empty if there are none */
+  std::vector<OrderBookEntry> getBucket(const std::string &timestamp);
+
+  /** every timestamp added, in order */
+  const std::vector<std::string> &getTimestamps() const { return timestamps; }
+  unsigned int getKeyframeInterval() const { return keyframeInterval; }
+  /** approximate heap bytes held by the store */
+  std::size_t getMemoryUsage() const;
+  /** differences applied to rebuild buckets so far */
+  std::uint64_t getStepsApplied() const { return stepsApplied; }
+
+private:
+  struct Change {
+    std::uint32_t index;
+    double amount;
+  };
+  /** turns a bucket into the next one. Indices point into the earlier
+   * bucket, every list is in bucket order */
+  struct Delta {
+    std::vector<std::uint32_t> removed;
+    std::vector<Change> changed;
+    std::vector<CompactOrder> added;
+  };
+
+  static bool lessByLevel(const CompactOrder &o1, const CompactOrder &o2);
+  static bool lessByOrder(const CompactOrder &o1, const CompactOrder &o2);
+  static Delta diff(const std::vector<CompactOrder> &from,
+                    const std::vector<CompactOrder> &to);
+  static void apply(const std::vector<CompactOrder> &from, const Delta &delta,
+                    std::vector<CompactOrder> &to);
+  std::uint16_t productIndex(const std::string &product);
+  void rebuild(std::size_t position);
+
+  unsigned int keyframeInterval;
+  std::vector<std::string> timestamps;
+  std::vector<std::string> products;
+  // Keyframe k is the bucket at position k * keyframeInterval
+  std::vector<std::vector<CompactOrder>> keyframes;
+  // Delta p turns bucket p - 1 into bucket p, unused at keyframe positions
+  std::vector<Delta> deltas;
+  // The last bucket added, the next one is diffed against it
+  std::vector<CompactOrder> last;
+  // The last bucket rebuilt, so reading in order applies one delta per read
+  std::vector<CompactOrder> current;
+  std::size_t currentPosition;
+  std::vector<CompactOrder> scratch;
+  std::uint64_t stepsApplied = 0;
+};
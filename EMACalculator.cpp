@@ -1 +1,67 @@
+#include "EMACalculator.hpp"
+#include <limits>
+#include <vector>
 
+// Each step reads the previous row of EMAs, the first one reads the seeds
+void EMACalculator::ema(const double *prices, std::size_t steps,
+                        std::size_t seriesCount, const double *seeds,
+                        double firstSnapshot, const double *periods,
+                        float *emas) {
+  std::vector<float> seedRow(seeds, seeds + seriesCount);
+  const float *previous = seedRow.data();
+  for (std::size_t t = 0; t < steps; t++) {
+    const double *row = prices + t * seriesCount;
+    float *out = emas + t * seriesCount;
+    double snapshot = firstSnapshot + t;
+    for (std::size_t s = 0; s < seriesCount; s++) {
+      out[s] = step(previous[s], row[s], smoothing(snapshot, periods[s]));
+    }
+    previous = out;
+  }
+}
+
+void EMACalculator::crossover(const float *emas, std::size_t steps,
+                              std::size_t seriesCount, const double *seeds,
+                              const double *bidDeltas,
+                              const double *askDeltas, std::int8_t *signals) {
+  std::vector<float> seedRow(seeds, seeds + seriesCount);
+  // The strategy compares in float, so the thresholds are rounded once here
+  std::vector<float> bidRow(bidDeltas, bidDeltas + seriesCount);
+  std::vector<float> askRow(askDeltas, askDeltas + seriesCount);
+  const float *previous = seedRow.data();
+  for (std::size_t t = 0; t < steps; t++) {
+    const float *row = emas + t * seriesCount;
+    std::int8_t *out = signals + t * seriesCount;
+    for (std::size_t s = 0; s < seriesCount; s++) {
+      out[s] = signal(previous[s], row[s], bidRow[s], askRow[s]);
+    }
+    previous = row;
+  }
+}
+
+// The running sums take the same additions and subtractions in the same order
+// as MeanReversionStrategy, so the averages round the same way
+void EMACalculator::sma(const double *prices, std::size_t steps,
+                        std::size_t seriesCount, std::size_t window,
+                        double *averages) {
+  std::vector<double> sums(seriesCount, 0.0);
+  double *sum = sums.data();
+  double size = window;
+  for (std::size_t t = 0; t < steps; t++) {
+    const double *row = prices + t * seriesCount;
+    double *out = averages + t * seriesCount;
+    if (t < window) {
+      for (std::size_t s = 0; s < seriesCount; s++) {
+        out[s] = std::numeric_limits<double>::quiet_NaN();
+        sum[s] += row[s];
+      }
+      continue;
+    }
+    const double *leaving = prices + (t - window) * seriesCount;
+    for (std::size_t s = 0; s < seriesCount; s++) {
+      out[s] = sum[s] / size;
+      sum[s] -= leaving[s];
+      sum[s] += row[s];
+    }
+  }
+}
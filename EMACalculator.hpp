@@ -1 +1,68 @@
+#pragma once
 
+#include <cstddef>
+#include <cstdint>
+
+/** the EMA crossover's arithmetic, for one value at a time and in batches.
+ * The batch functions take many price series at once, laid out time-major:
+ * the prices of every series at step t are contiguous, at
+ * prices[t * seriesCount + s]. The inner loops run across the series, which
+ * do not depend on each other, so the compiler vectorises them. They do the
+ * same operations in the same order as the one-value versions, so the
+ * results are bit for bit those of EMACrossoverStrategy and
+ * MeanReversionStrategy.
+ */
+class EMACalculator {
+public:
+  /** signals of crossover, the order the strategy would place */
+  static constexpr std::int8_t sell = -1;
+  static constexpr std::int8_t hold = 0;
+  static constexpr std::int8_t buy = 1;
+
+  /** smoothing factor of the EMA at a snapshot number. The period caps the
+   * snapshot number, an infinite period gives the streaming strategy's
+   * factor 2 / (snapshot + 1) */
+  static double smoothing(double snapshot, double period) {
+    return 2.0 / ((snapshot < period ? snapshot : period) + 1.0);
+  }
+
+  /** one EMA step, exactly as EMACrossoverStrategy computes it: both halves
+   * are rounded to float, and a half that rounds to 0 counts as 1 */
+  static float step(float oldEMA, double price, double factor) {
+    float weighted = price * factor;
+    float carried = oldEMA * (1.0 - factor);
+    weighted = weighted == 0 ? 1 : weighted;
+    carried = carried == 0 ? 1 : carried;
+    return weighted + carried;
+  }
+
+  /** one crossover decision on the change between two EMAs */
+  static std::int8_t signal(float oldEMA, float newEMA, float bidDelta,
+                            float askDelta) {
+    float delta = oldEMA - newEMA;
+    return delta > bidDelta ? buy : (delta < askDelta ? sell : hold);
+  }
+
+  /** EMAs of many series. seeds[s] is the moving average series s starts
+   * from, firstSnapshot the snapshot number of the first price (the
+   * strategy's snapshotCounter, 2 for a replay from the start) and
+   * periods[s] caps the snapshot number of series s. emas is laid out like
+   * the prices */
+  static void ema(const double *prices, std::size_t steps,
+                  std::size_t seriesCount, const double *seeds,
+                  double firstSnapshot, const double *periods, float *emas);
+
+  /** crossover signals of many series, from the EMAs computed by ema and
+   * the seeds they started from, with per-series thresholds */
+  static void crossover(const float *emas, std::size_t steps,
+                        std::size_t seriesCount, const double *seeds,
+                        const double *bidDeltas, const double *askDeltas,
+                        std::int8_t *signals);
+
+  /** trailing moving averages of many series over the `window` prices before
+   * each step, as MeanReversionStrategy keeps them. Steps without a full
+   * window get NaN */
+  static void sma(const double *prices, std::size_t steps,
+                  std::size_t seriesCount, std::size_t window,
+                  double *averages);
+};
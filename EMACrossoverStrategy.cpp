@@ -0,0 +1,115 @@
+#include "EMACrossoverStrategy.hpp"
+#include "EMACalculator.hpp"
+#include "Instrumentation.hpp"
+#include <limits>
+
+OrderBookType EMACrossoverStrategy::onSnapshot(const OrderBookEntry &entry,
+                                               std::ostream &log) {
+  // If it's the first average we calculate (i.e. we don't have any former Exponential Moving Average value in our vector), we will enter in this flow
+  if (movingAverages.size() == 0) {
+    calculateMA(log);
+    return OrderBookType::unknown;
+  }
+  return calculateEMA(entry, log);
+}
+
+void EMACrossoverStrategy::saveState(CheckpointWriter &out) const {
+  out.write(movingAverages);
+  out.write(movingAverageAcc);
+  out.write(bidEntriesCounter);
+}
+
+void EMACrossoverStrategy::loadState(CheckpointReader &in) {
+  in.read(movingAverages);
+  in.read(movingAverageAcc);
+  in.read(bidEntriesCounter);
+}
+
+// The function calculates the Exponential Moving Average and based on its value evaluates the course of action for the bot flow
+OrderBookType EMACrossoverStrategy::calculateEMA(const OrderBookEntry &entry,
+                                                 std::ostream &log) {
+  // The previous EMA value is picked from the movingAverages vector
+  // Note that the movingAverages vector is filled up in this very function, as well as in the calculateMA function (for the first element)
+  float oldEMA = movingAverages[movingAverages.size() - 1];
+  float newEMA;
+  float delta;
+  {
+    // Only the EMA math is timed as this stage, the orders it leads to are timed on their own
+    MERKEL_TIME_STAGE(Stage::emaCalculation);
+    // The smoothing factor (2) is divided by the total number of movingAverages calculated up to this moment plus 1
+    double factor = EMACalculator::smoothing(
+        snapshotCounter, std::numeric_limits<double>::infinity());
+    // The price of the entry we are currently iterating on and the previous EMA are weighed with it and summed
+    // The step is shared with the batch calculations of EMACalculator, so both give the same EMAs
+    newEMA = EMACalculator::step(oldEMA, entry.price, factor);
+    // The difference between the previous EMA and the current EMA is calculated
+    // At crossover, i.e. change in direction, we perform a sell/buy action based on this value and the selected thresholds
+    delta = oldEMA - newEMA;
+  }
+  // The thresholds of the traded product were resolved once, when the strategy was set up
+  float acceptedBidDelta = config.bidDelta;
+  float acceptedAskDelta = config.askDelta;
+
+  // We print the current bot situation on the logging file
+  log << "calculateEMA "
+      << "Old EMA is" << oldEMA << " | New EMA is " << newEMA
+      << " | Δ with previous EMA is " << delta << std::endl;
+
+  // We push the newly generated EMA to our EMA vector
+  movingAverages.push_back(newEMA);
+
+  // If there exists the conditions to place a bid, bot will place one
+  if (delta > acceptedBidDelta) {
+    return OrderBookType::bid;
+  }
+  // If there exists the conditions to place an ask, bot will place one
+  if (delta < acceptedAskDelta) {
+    return OrderBookType::ask;
+  }
+  // If current delta corresponds to no bid/ask conditions, bot will sleep
+  if (delta > acceptedAskDelta && delta < acceptedBidDelta) {
+    log << "Δ with previous EMA is irrelevant. Bot is sleeping..." << std::endl;
+  }
+  return OrderBookType::unknown;
+}
+
+void EMACrossoverStrategy::snapshotInputs(
+    const std::vector<OrderBookEntry> &bids, double &seed,
+    std::vector<double> &prices) {
+  // The same cadence and accumulation as onTick, onEntry and calculateMA, without the EMAs
+  int timestampCounter = 0;
+  double snapshotCounter = 0;
+  std::string currentTimestamp = "";
+  double accumulated = 0;
+  double entries = 0;
+  bool seeded = false;
+  seed = 0;
+  for (const OrderBookEntry &entry : bids) {
+    if (!seeded) {
+      accumulated = accumulated + entry.price;
+      entries++;
+    }
+    if (entry.timestamp == currentTimestamp) {
+      continue;
+    }
+    currentTimestamp = entry.timestamp;
+    if (!advanceCadence(timestampCounter, snapshotCounter)) {
+      continue;
+    }
+    if (seeded) {
+      prices.push_back(entry.price);
+    } else {
+      seed = accumulated / entries;
+      seeded = true;
+    }
+  }
+}
+
+// This function will be called when creating our first snapshot
+void EMACrossoverStrategy::calculateMA(std::ostream &log) {
+  // We print the current bot situation on the logging file
+  log << "calculateMA " << movingAverageAcc / bidEntriesCounter << std::endl;
+  // We push the newly generated MA to our EMA vector. This first element will be less precise than an actual EMA but will let us start the calculations from an approximated point
+  // Our MA is calculated by dividing the total amount that we have been accumulating with the previous iterations, and dividing it by the total number of bids taken into account
+  movingAverages.push_back(movingAverageAcc / bidEntriesCounter);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "TradingStrategy.hpp"
+#include <vector>
+
+/** buys when the EMA of the bids turns down and sells when it turns up,
+ * beyond the product's delta thresholds */
+class EMACrossoverStrategy : public TradingStrategy<EMACrossoverStrategy> {
+public:
+  void onEntry(const OrderBookEntry &entry) {
+    // We immediately increase the bidEntries counter. Such value will later be useful to calculate the first Moving Average
+    bidEntriesCounter++;
+    if (movingAverages.size() == 0) {
+      // Since the formula for Exponential Moving Average is recursive, we have to start from a regular Moving Average
+      movingAverageAcc = movingAverageAcc + entry.price;
+    }
+  }
+  OrderBookType onSnapshot(const OrderBookEntry &entry, std::ostream &log);
+  void saveState(CheckpointWriter &out) const;
+  void loadState(CheckpointReader &in);
+  static const char *name() { return "ema"; }
+  std::size_t stateMemoryUsage() const {
+    return MemoryReport::heapBlock(movingAverages.capacity() * sizeof(double));
+  }
+
+  /** the moving average first, then every EMA calculated so far */
+  const std::vector<double> &getMovingAverages() const {
+    return movingAverages;
+  }
+  /** what the EMA of a replay of these bids from the start is fed: the
+   * moving average it is seeded with, then the price of every snapshot after
+   * it, the first one being snapshot 2. Input of EMACalculator::ema */
+  static void snapshotInputs(const std::vector<OrderBookEntry> &bids,
+                             double &seed, std::vector<double> &prices);
+
+private:
+  OrderBookType calculateEMA(const OrderBookEntry &entry, std::ostream &log);
+  void calculateMA(std::ostream &log);
+
+  std::vector<double> movingAverages;
+  double movingAverageAcc = 0;
+  double bidEntriesCounter = 0;
+};
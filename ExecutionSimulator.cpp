@@ -0,0 +1,244 @@
+#include "ExecutionSimulator.hpp"
+#include "Instrumentation.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <exception>
+
+ExecutionSimulator::ExecutionSimulator(const ExecutionConfig &_config)
+    : config(_config) {}
+
+unsigned int ExecutionSimulator::submit(const OrderBookEntry &order) {
+  std::int64_t sent;
+  try {
+    sent = Timestamp::toMicros(order.timestamp);
+  } catch (const std::exception &e) {
+    return 0;
+  }
+  SimulatedOrder simulated{nextId++, order, sent, sent + config.latencyMicros,
+                           order.amount, -1, false, 0, 0, 0};
+  inFlight.push_back(simulated);
+  ordersSent++;
+  amountSent += order.amount;
+  return simulated.id;
+}
+
+// Nothing is read from the bucket while no order is open, so most of a
+// replay costs a single emptiness check per bucket
+std::vector<SimulatedFill>
+ExecutionSimulator::advance(OrderBook &orderBook,
+                            const std::string &timestamp) {
+  std::vector<SimulatedFill> fills;
+  // The fills of the previous bucket have been settled by now
+  settling.clear();
+  if (inFlight.empty() && resting.empty()) {
+    return fills;
+  }
+  MERKEL_TIME_STAGE(Stage::simulateExecution);
+  std::int64_t now;
+  try {
+    now = Timestamp::toMicros(timestamp);
+  } catch (const std::exception &e) {
+    return fills;
+  }
+  while (!inFlight.empty() && inFlight.front().arrival <= now) {
+    resting.push_back(inFlight.front());
+    inFlight.pop_front();
+  }
+
+  const std::vector<OrderBookEntry> &bucket = orderBook.getBucket(timestamp);
+  for (SimulatedOrder &order : resting) {
+    if (now - order.arrival > config.lifetimeMicros) {
+      close(order);
+      order.remaining = 0;
+      ordersExpired++;
+      continue;
+    }
+    trade(order, orderBook, bucket, timestamp, now, fills);
+    if (order.remaining <= 0) {
+      settling.push_back(order);
+    }
+  }
+  resting.erase(std::remove_if(resting.begin(), resting.end(),
+                               [](const SimulatedOrder &o) {
+                                 return o.remaining <= 0;
+                               }),
+                resting.end());
+  MERKEL_COUNT(Counter::fills, fills.size());
+  return fills;
+}
+
+// Price-time priority against one bucket: opposing orders crossing our price
+// first go to the orders ahead of us, then to us
+void ExecutionSimulator::trade(SimulatedOrder &order, OrderBook &orderBook,
+                               const std::vector<OrderBookEntry> &bucket,
+                               const std::string &timestamp, std::int64_t now,
+                               std::vector<SimulatedFill> &fills) {
+  const bool buying = order.order.orderType == OrderBookType::bid;
+  const OrderBookType opposite =
+      buying ? OrderBookType::ask : OrderBookType::bid;
+  const double price = order.order.price;
+  double better = 0;
+  double level = 0;
+  crossing.clear();
+  for (const OrderBookEntry &e : bucket) {
+    if (e.product != order.order.product) {
+      continue;
+    }
+    if (e.orderType == order.order.orderType) {
+      if (buying ? e.price > price : e.price < price) {
+        better += e.amount;
+      } else if (e.price == price) {
+        level += e.amount;
+      }
+    } else if (e.orderType == opposite &&
+               (buying ? e.price <= price : e.price >= price)) {
+      crossing.push_back(Level{e.price, e.amount});
+    }
+  }
+
+  // On arrival the whole level is ahead of us. Later on, the level can only
+  // shrink for us: whatever joins it at our price queues behind us
+  const bool arriving = order.queueAhead < 0;
+  order.queueAhead = arriving ? level : std::min(order.queueAhead, level);
+  if (crossing.empty()) {
+    return;
+  }
+  // Best crossing price first
+  std::sort(crossing.begin(), crossing.end(),
+            [buying](const Level &l1, const Level &l2) {
+              return buying ? l1.price < l2.price : l1.price > l2.price;
+            });
+
+  const BookSnapshot &snapshot =
+      orderBook.getSnapshot(order.order.product, timestamp);
+  SaleContext context{snapshot.maxAsk, snapshot.minAsk, snapshot.maxBid,
+                      snapshot.minBid};
+  const double aheadAtStart = better + order.queueAhead;
+  double ahead = aheadAtStart;
+  for (const Level &l : crossing) {
+    if (order.remaining <= 0) {
+      break;
+    }
+    double toAhead = std::min(l.amount, ahead);
+    ahead -= toAhead;
+    double amount = std::min(l.amount - toAhead, order.remaining);
+    if (amount <= 0) {
+      continue;
+    }
+    // Crossing the book on arrival takes the resting price, resting in the
+    // book gets our own price
+    OrderBookEntry sale{arriving ? l.price : price, amount, timestamp,
+                        order.order.product,
+                        buying ? OrderBookType::bidsale
+                               : OrderBookType::asksale};
+    sale.accountId = order.order.accountId;
+    sale.context = context;
+    fills.push_back(SimulatedFill{order.id, sale});
+    order.remaining -= amount;
+    order.pendingFills++;
+    order.filledAt = now;
+  }
+  // What traded ahead of us beyond the better prices came out of our level
+  double tradedAhead = aheadAtStart - ahead;
+  order.queueAhead =
+      std::max(0.0, order.queueAhead - std::max(0.0, tradedAhead - better));
+}
+
+ExecutionSimulator::SimulatedOrder *
+ExecutionSimulator::find(unsigned int orderId) {
+  for (SimulatedOrder &o : resting) {
+    if (o.id == orderId) {
+      return &o;
+    }
+  }
+  for (SimulatedOrder &o : settling) {
+    if (o.id == orderId) {
+      return &o;
+    }
+  }
+  return nullptr;
+}
+
+// The counters only follow the fills the wallet took
+void ExecutionSimulator::confirm(const SimulatedFill &fill) {
+  SimulatedOrder *order = find(fill.orderId);
+  if (order == nullptr) {
+    return;
+  }
+  order->pendingFills--;
+  order->confirmed += fill.sale.amount;
+  fillCount++;
+  amountFilled += fill.sale.amount;
+  if (!order->filledBefore) {
+    order->filledBefore = true;
+    firstFillMicros += order->filledAt - order->sent;
+    firstFills++;
+  }
+  if (order->remaining <= 0 && order->pendingFills == 0) {
+    ordersFilled++;
+  }
+}
+
+void ExecutionSimulator::reject(const SimulatedFill &fill) {
+  SimulatedOrder *order = find(fill.orderId);
+  if (order == nullptr) {
+    return;
+  }
+  order->pendingFills--;
+  fillsRejected++;
+}
+
+void ExecutionSimulator::cancel(unsigned int orderId) {
+  for (std::deque<SimulatedOrder>::iterator o = inFlight.begin();
+       o != inFlight.end(); ++o) {
+    if (o->id == orderId) {
+      close(*o);
+      inFlight.erase(o);
+      ordersCancelled++;
+      return;
+    }
+  }
+  for (std::vector<SimulatedOrder>::iterator o = resting.begin();
+       o != resting.end(); ++o) {
+    if (o->id == orderId) {
+      close(*o);
+      resting.erase(o);
+      ordersCancelled++;
+      return;
+    }
+  }
+  for (std::vector<SimulatedOrder>::iterator o = settling.begin();
+       o != settling.end(); ++o) {
+    if (o->id == orderId) {
+      close(*o);
+      settling.erase(o);
+      ordersCancelled++;
+      return;
+    }
+  }
+}
+
+void ExecutionSimulator::close(const SimulatedOrder &order) {
+  closed.push_back(ClosedOrder{order.id, order.order.orderType,
+                               order.order.amount - order.confirmed});
+}
+
+std::vector<ClosedOrder> ExecutionSimulator::takeClosed() {
+  std::vector<ClosedOrder> taken;
+  taken.swap(closed);
+  return taken;
+}
+
+void ExecutionSimulator::printReport(std::ostream &os) const {
+  os << "Simulated orders: " << ordersSent << " sent, " << ordersFilled
+     << " filled, " << ordersExpired << " expired, " << ordersCancelled
+     << " cancelled, " << getOpenOrders() << " open" << std::endl;
+  os << "Simulated fills: " << fillCount << ", "
+     << (amountSent > 0 ? amountFilled / amountSent * 100 : 0)
+     << "% of the amount sent, " << fillsRejected
+     << " rejected by the wallet" << std::endl;
+  if (firstFills > 0) {
+    os << "Decision to first fill (us) mean: " << firstFillMicros / firstFills
+       << std::endl;
+  }
+}
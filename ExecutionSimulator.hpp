@@ -0,0 +1,128 @@
+#pragma once
+
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/** how the simulated exchange treats the bot's orders */
+struct ExecutionConfig {
+  /** time from the bot's decision until its order reaches the book, in
+   * microseconds */
+  std::int64_t latencyMicros = 0;
+  /** time an order rests in the book before it is cancelled, in
+   * microseconds */
+  std::int64_t lifetimeMicros = 60000000;
+};
+
+/** one fill of a simulated order, a bidsale or asksale of the bot */
+struct SimulatedFill {
+  unsigned int orderId;
+  OrderBookEntry sale;
+};
+
+/** an order that left the simulator before all of it filled: expired or
+ * cancelled, with the amount that never filled */
+struct ClosedOrder {
+  unsigned int orderId;
+  OrderBookType side;
+  double unfilled;
+};
+
+/** fills the bot's orders against the buckets that follow them, instead of
+ * at once against the bucket that triggered them.
+ * An order reaches the book after the entry latency and joins the back of
+ * its price level: what rests at its price when it arrives, and anything at
+ * a better price, trades before it does. Opposing orders that cross its
+ * price then fill it, in part or in full, bucket after bucket until it is
+ * done or its lifetime runs out. The bot's orders never change the book,
+ * they are assumed too small to move the market */
+class ExecutionSimulator {
+public:
+  explicit ExecutionSimulator(const ExecutionConfig &_config);
+
+  /** the bot sends an order at the order's timestamp. Returns its id, 0 if
+   * the timestamp cannot be read */
+  unsigned int submit(const OrderBookEntry &order);
+  /** trade the orders that have reached the book by a timestamp against the
+   * bucket of that timestamp. Buckets have to come in time order, and every
+   * fill returned is confirmed or rejected before the next bucket */
+  std::vector<SimulatedFill> advance(OrderBook &orderBook,
+                                     const std::string &timestamp);
+  /** the wallet took a fill: it counts towards the fills of the report */
+  void confirm(const SimulatedFill &fill);
+  /** the wallet could not take a fill. It is not counted, and its order is
+   * expected to be cancelled */
+  void reject(const SimulatedFill &fill);
+  /** drop what is left of an order, including one whose last fills are
+   * waiting for confirmation */
+  void cancel(unsigned int orderId);
+
+  /** the orders closed since the last call */
+  std::vector<ClosedOrder> takeClosed();
+
+  /** orders sent and not yet filled, cancelled or expired */
+  std::size_t getOpenOrders() const { return inFlight.size() + resting.size(); }
+  const ExecutionConfig &getConfig() const { return config; }
+  /** orders, fills and time to first fill so far */
+  void printReport(std::ostream &os) const;
+
+private:
+  struct SimulatedOrder {
+    unsigned int id;
+    OrderBookEntry order;
+    std::int64_t sent;
+    std::int64_t arrival;
+    double remaining;
+    // Amount at the order's own price that is ahead of it, -1 until the
+    // order has seen its first bucket
+    double queueAhead;
+    bool filledBefore;
+    // Fills returned by advance and not yet confirmed or rejected, and the
+    // time of the bucket they came from
+    unsigned int pendingFills;
+    std::int64_t filledAt;
+    // Amount of the fills the wallet took
+    double confirmed;
+  };
+  /** an opposing order crossing the price of a simulated one */
+  struct Level {
+    double price;
+    double amount;
+  };
+
+  void trade(SimulatedOrder &order, OrderBook &orderBook,
+             const std::vector<OrderBookEntry> &bucket,
+             const std::string &timestamp, std::int64_t now,
+             std::vector<SimulatedFill> &fills);
+  SimulatedOrder *find(unsigned int orderId);
+  void close(const SimulatedOrder &order);
+
+  ExecutionConfig config;
+  unsigned int nextId = 1;
+  // Orders still on their way to the exchange, in order of arrival since
+  // every order has the same latency
+  std::deque<SimulatedOrder> inFlight;
+  std::vector<SimulatedOrder> resting;
+  // Orders fully traded in the last bucket, until their fills are settled
+  std::vector<SimulatedOrder> settling;
+  // Orders expired or cancelled since the last takeClosed
+  std::vector<ClosedOrder> closed;
+  // Reused for the crossing orders of each bucket
+  std::vector<Level> crossing;
+
+  unsigned int ordersSent = 0;
+  unsigned int ordersFilled = 0;
+  unsigned int ordersExpired = 0;
+  unsigned int ordersCancelled = 0;
+  unsigned int fillCount = 0;
+  unsigned int fillsRejected = 0;
+  double amountSent = 0;
+  double amountFilled = 0;
+  // Sum over the filled orders of the time from decision to first fill
+  double firstFillMicros = 0;
+  unsigned int firstFills = 0;
+};
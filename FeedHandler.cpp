@@ -0,0 +1,131 @@
+#include "FeedHandler.hpp"
+#include "Timestamp.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+FeedHandler::FeedHandler(const std::string &_socketPath)
+    : socketPath(_socketPath), socketFd(-1), epollFd(-1),
+      buffers(datagramsPerRead * feedBatchSize), headers(datagramsPerRead),
+      vectors(datagramsPerRead), currentMicros(-1), messageCount(0),
+      datagramCount(0), emptyReadCount(0), busyPoll(false), finished(false) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    std::cout << "FeedHandler socket path too long " << socketPath << std::endl;
+    return;
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+  ::unlink(socketPath.c_str());
+
+  socketFd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  if (socketFd < 0 ||
+      ::bind(socketFd, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) < 0) {
+    std::cout << "FeedHandler cannot bind " << socketPath << std::endl;
+    return;
+  }
+  // A deep receive queue lets the exchange burst a whole bucket at once
+  int bufferSize = 4 * 1024 * 1024;
+  ::setsockopt(socketFd, SOL_SOCKET, SO_RCVBUF, &bufferSize,
+               sizeof(bufferSize));
+
+  epollFd = ::epoll_create1(0);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = socketFd;
+  if (epollFd < 0 ||
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, socketFd, &event) < 0) {
+    std::cout << "FeedHandler cannot poll " << socketPath << std::endl;
+    return;
+  }
+
+  for (unsigned int i = 0; i < datagramsPerRead; i++) {
+    vectors[i].iov_base = &buffers[i * feedBatchSize];
+    vectors[i].iov_len = feedBatchSize * sizeof(FeedMessage);
+    headers[i].msg_hdr.msg_iov = &vectors[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+FeedHandler::~FeedHandler() {
+  if (epollFd >= 0)
+    ::close(epollFd);
+  if (socketFd >= 0) {
+    ::close(socketFd);
+    ::unlink(socketPath.c_str());
+  }
+}
+
+int FeedHandler::receiveBatch() {
+  while (true) {
+    int received = ::recvmmsg(socketFd, headers.data(), datagramsPerRead,
+                              MSG_DONTWAIT, nullptr);
+    if (received > 0) {
+      return received;
+    }
+    // Only an empty queue or a signal is worth another read
+    if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+        errno != EINTR) {
+      std::cout << "FeedHandler recvmmsg failed" << std::endl;
+      finished = true;
+      return 0;
+    }
+    emptyReadCount++;
+    if (busyPoll) {
+#if defined(__x86_64__) || defined(__i386__)
+      // Eases off the core's sibling hyperthread while spinning
+      __builtin_ia32_pause();
+#endif
+      continue;
+    }
+    // Nothing queued: sleep until the socket is readable
+    epoll_event event;
+    if (::epoll_wait(epollFd, &event, 1, -1) < 0 && errno != EINTR) {
+      std::cout << "FeedHandler epoll_wait failed" << std::endl;
+      finished = true;
+      return 0;
+    }
+  }
+}
+
+bool FeedHandler::decode(const FeedMessage &message, OrderBook &orderBook) {
+  messageCount++;
+  switch (message.type) {
+  case FeedMessageType::product:
+    if (products.size() <= message.productId) {
+      products.resize(message.productId + 1);
+    }
+    products[message.productId].assign(
+        message.body.symbol,
+        strnlen(message.body.symbol, sizeof(message.body.symbol)));
+    return false;
+  case FeedMessageType::order:
+    // The timestamp text is only formatted once per bucket
+    if (message.timestamp != currentMicros) {
+      currentMicros = message.timestamp;
+      currentTimestamp = Timestamp::fromMicros(currentMicros);
+    }
+    // Orders of an unknown product or side are dropped
+    if (message.productId >= products.size() ||
+        (message.side != static_cast<std::uint8_t>(OrderBookType::bid) &&
+         message.side != static_cast<std::uint8_t>(OrderBookType::ask))) {
+      return false;
+    }
+    orderBook.insertOrder(
+        OrderBookEntry{message.body.order.price, message.body.order.amount,
+                       currentTimestamp, products[message.productId],
+                       static_cast<OrderBookType>(message.side)});
+    return false;
+  case FeedMessageType::endOfBucket:
+    return currentMicros >= 0;
+  case FeedMessageType::endOfFeed:
+    finished = true;
+    return false;
+  default:
+    return false;
+  }
+}
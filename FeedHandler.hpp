@@ -0,0 +1,86 @@
+#pragma once
+
+#include "FeedProtocol.hpp"
+#include "Instrumentation.hpp"
+#include "OrderBook.hpp"
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+/** receives the mock exchange's binary feed on a Unix datagram socket and
+ * decodes it straight into OrderBook buckets.
+ * Reads are batched: one epoll wakeup drains up to datagramsPerRead
+ * datagrams with a single recvmmsg call. In busy-poll mode the handler
+ * never sleeps, it keeps calling recvmmsg until datagrams arrive, which
+ * spares the wakeup at the cost of a whole core.
+ */
+class FeedHandler {
+public:
+  /** bind the feed socket at the given path */
+  FeedHandler(const std::string &socketPath);
+  ~FeedHandler();
+  FeedHandler(const FeedHandler &) = delete;
+  FeedHandler &operator=(const FeedHandler &) = delete;
+
+  bool isOpen() const { return socketFd >= 0 && epollFd >= 0; }
+  void setBusyPoll(bool _busyPoll) { busyPoll = _busyPoll; }
+  /** decode the feed into the order book until the end of the feed.
+   * onBucket(timestamp) is called once all the orders of a timestamp are in
+   * the book; the time from the exchange sending the bucket to onBucket
+   * returning is recorded as tick-to-decision latency.
+   */
+  template <typename Callback> void run(OrderBook &orderBook, Callback onBucket);
+
+  /** tick-to-decision latency in nanoseconds */
+  const LatencyHistogram &getLatency() const { return latency; }
+  std::uint64_t getMessageCount() const { return messageCount; }
+  std::uint64_t getDatagramCount() const { return datagramCount; }
+  /** reads that found nothing queued */
+  std::uint64_t getEmptyReadCount() const { return emptyReadCount; }
+
+private:
+  static const unsigned int datagramsPerRead = 32;
+
+  /** wait for the socket and read a batch, returns the number of datagrams */
+  int receiveBatch();
+  /** decode one record, returns true at the end of a bucket */
+  bool decode(const FeedMessage &message, OrderBook &orderBook);
+
+  std::string socketPath;
+  int socketFd;
+  int epollFd;
+  std::vector<FeedMessage> buffers;
+  std::vector<mmsghdr> headers;
+  std::vector<iovec> vectors;
+
+  // Product symbols by id, and the text of the timestamp being decoded
+  std::vector<std::string> products;
+  std::int64_t currentMicros;
+  std::string currentTimestamp;
+
+  LatencyHistogram latency;
+  std::uint64_t messageCount;
+  std::uint64_t datagramCount;
+  std::uint64_t emptyReadCount;
+  bool busyPoll;
+  bool finished;
+};
+
+template <typename Callback>
+void FeedHandler::run(OrderBook &orderBook, Callback onBucket) {
+  while (!finished && isOpen()) {
+    int received = receiveBatch();
+    for (int d = 0; d < received; d++) {
+      unsigned int count = headers[d].msg_len / sizeof(FeedMessage);
+      const FeedMessage *batch = &buffers[d * feedBatchSize];
+      datagramCount++;
+      for (unsigned int i = 0; i < count; i++) {
+        if (decode(batch[i], orderBook)) {
+          onBucket(currentTimestamp);
+          latency.record(feedClockNanos() - batch[i].sendTime);
+        }
+      }
+    }
+  }
+}
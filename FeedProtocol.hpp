@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/** message kinds of the binary feed and order protocol */
+enum class FeedMessageType : std::uint8_t {
+  /** assigns a product id to the symbol carried in the body */
+  product = 1,
+  /** one order of the current timestamp bucket */
+  order = 2,
+  /** every order of the timestamp has been sent */
+  endOfBucket = 3,
+  /** the replay is over */
+  endOfFeed = 4,
+  /** an order sent by a client to the exchange */
+  newOrder = 5
+};
+
+struct FeedOrder {
+  double price;
+  double amount;
+};
+
+/** fixed size record of the feed, datagrams carry a batch of them */
+struct FeedMessage {
+  FeedMessageType type;
+  /** OrderBookType of an order */
+  std::uint8_t side;
+  std::uint16_t productId;
+  std::uint32_t sequence;
+  /** exchange time, microseconds since the epoch */
+  std::int64_t timestamp;
+  /** sender's steady clock when the datagram left, for latency reporting */
+  std::int64_t sendTime;
+  union {
+    FeedOrder order;
+    char symbol[16];
+  } body;
+};
+
+static_assert(sizeof(FeedMessage) == 40, "FeedMessage is a wire format");
+
+/** maximum number of records in one datagram */
+const unsigned int feedBatchSize = 64;
+
+/** steady clock in nanoseconds, comparable between processes of one host */
+inline std::int64_t feedClockNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
@@ -0,0 +1,379 @@
+#include "HeadlessMain.hpp"
+#include "CSVReader.hpp"
+#include "EMACrossoverStrategy.hpp"
+#include "MeanReversionStrategy.hpp"
+#include "OrderBook.hpp"
+#include "ParallelBacktest.hpp"
+#include "Timestamp.hpp"
+#include "VWAPDeviationStrategy.hpp"
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+HeadlessMain::HeadlessMain(int argc, char *argv[])
+    : arguments(argv + 1, argv + argc) {}
+
+bool HeadlessMain::isHeadless(int argc, char * /*argv*/[]) { return argc > 1; }
+
+bool HeadlessMain::parseArguments() {
+  for (unsigned int i = 0; i < arguments.size(); i++) {
+    const std::string &arg = arguments[i];
+    // Options without a value
+    if (arg == "--verify") {
+      verifySegments = true;
+      continue;
+    } else if (arg == "--busy-poll") {
+      tuningConfig.busyPoll = true;
+      continue;
+    } else if (arg == "--lock-memory") {
+      tuningConfig.lockMemory = true;
+      continue;
+    } else if (arg == "--huge-pages") {
+      tuningConfig.hugePages = true;
+      continue;
+    } else if (arg == "--memory-report") {
+      memoryReport = true;
+      continue;
+    }
+    if (i + 1 >= arguments.size()) {
+      std::cout << "HeadlessMain missing value for " << arg << std::endl;
+      return false;
+    }
+    const std::string &value = arguments[++i];
+    if (arg == "--bot") {
+      product = value;
+    } else if (arg == "--strategy") {
+      strategyName = value;
+    } else if (arg == "--data") {
+      dataFile = value;
+    } else if (arg == "--checkpoint-dir") {
+      checkpointDirectory = value;
+    } else if (arg == "--checkpoint-every") {
+      try {
+        checkpointEvery = std::stoul(value);
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad checkpoint interval " << value
+                  << std::endl;
+        return false;
+      }
+    } else if (arg == "--segments" || arg == "--warmup") {
+      try {
+        (arg == "--segments" ? segmentCount : warmupTimestamps) =
+            std::stoul(value);
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad value for " << arg << " " << value
+                  << std::endl;
+        return false;
+      }
+    } else if (arg == "--bars") {
+      try {
+        for (const std::string &interval : CSVReader::tokenise(value, ',')) {
+          barIntervals.push_back(BarBuilder::parseInterval(interval));
+        }
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad bar intervals " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--exec-latency-us" || arg == "--exec-lifetime-us") {
+      try {
+        (arg == "--exec-latency-us" ? executionConfig.latencyMicros
+                                    : executionConfig.lifetimeMicros) =
+            std::stoll(value);
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad value for " << arg << " " << value
+                  << std::endl;
+        return false;
+      }
+      simulateExecution = true;
+    } else if (arg == "--max-position" || arg == "--max-notional" ||
+               arg == "--price-band") {
+      try {
+        double limit = std::stod(value);
+        if (arg == "--max-position") {
+          riskLimits.maxPosition = limit;
+        } else if (arg == "--max-notional") {
+          riskLimits.maxNotional = limit;
+        } else {
+          riskLimits.priceBand = limit;
+        }
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad value for " << arg << " " << value
+                  << std::endl;
+        return false;
+      }
+      riskChecks = true;
+    } else if (arg == "--max-orders" || arg == "--rate-window-us") {
+      try {
+        if (arg == "--max-orders") {
+          riskLimits.maxOrders = std::stoul(value);
+        } else {
+          riskLimits.windowMicros = std::stoll(value);
+        }
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad value for " << arg << " " << value
+                  << std::endl;
+        return false;
+      }
+      riskChecks = true;
+    } else if (arg == "--price-offset") {
+      try {
+        priceOffset = std::stod(value);
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad price offset " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--cpu") {
+      try {
+        tuningConfig.cpu = std::stoi(value);
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad cpu " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--resume") {
+      resumePath = value;
+    } else if (arg == "--shm") {
+      sharedBookName = value;
+    } else if (arg == "--feed") {
+      feedSocket = value;
+    } else if (arg == "--data-dir") {
+      dataDirectory = value;
+    } else if (arg == "--memory-budget") {
+      try {
+        memoryBudgetMB = std::stoul(value);
+      } catch (const std::exception &e) {
+        std::cout << "HeadlessMain bad memory budget " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--log") {
+      logFile = value;
+    } else {
+      std::cout << "HeadlessMain unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+void HeadlessMain::printUsage() {
+  std::cout << "Usage: merkelbot --bot PRODUCT [--strategy ema|meanrev|vwap] "
+               "[--data FILE | --data-dir DIR [--memory-budget MB]] "
+               "[--feed SOCKET] [--shm NAME] [--checkpoint-dir DIR "
+               "--checkpoint-every N] [--resume FILE] "
+               "[--segments K [--warmup N] [--verify]] [--bars 1s,1m] "
+               "[--exec-latency-us N] [--exec-lifetime-us N] "
+               "[--price-offset F] [--max-position X] [--max-notional X] "
+               "[--max-orders N [--rate-window-us W]] [--price-band F] "
+               "[--cpu N] [--busy-poll] [--lock-memory] [--huge-pages] "
+               "[--memory-report] [--log FILE]"
+            << std::endl;
+}
+
+// A data directory is replayed day by day through the catalog, a single file is loaded whole
+template <typename Strategy>
+void HeadlessMain::runStrategy(const ProductConfig &config,
+                               HostTuning &hostTuning) {
+  Strategy strategy;
+  std::unique_ptr<SharedBookPublisher> publisher;
+  if (!sharedBookName.empty()) {
+    publisher.reset(new SharedBookPublisher{sharedBookName});
+    merkelBot.setSharedBookPublisher(publisher.get());
+  }
+  if (!feedSocket.empty()) {
+    // Orders go back to the exchange on its order socket, next to the feed one
+    OrderBook orderBook;
+    FeedHandler feed{feedSocket};
+    OrderGateway gateway{feedSocket + ".orders"};
+    if (feed.isOpen()) {
+      // Nothing is loaded ahead of a feed, the feed is decoded on this thread
+      hostTuning.pin();
+      feed.setBusyPoll(tuningConfig.busyPoll);
+      merkelBot.setOrderGateway(&gateway);
+      merkelBot.run(feed, orderBook, wallet, config, strategy);
+      merkelBot.setOrderGateway(nullptr);
+      const LatencyHistogram &latency = feed.getLatency();
+      std::cout << "Feed messages: " << feed.getMessageCount()
+                << " datagrams: " << feed.getDatagramCount()
+                << " orders sent: " << gateway.getSentCount()
+                << " empty reads: " << feed.getEmptyReadCount() << std::endl;
+      std::cout << "Tick-to-decision latency (ns) p50: "
+                << latency.percentile(0.5)
+                << " p99: " << latency.percentile(0.99)
+                << " p999: " << latency.percentile(0.999)
+                << " max: " << latency.getMax() << std::endl;
+      printMemory("after run", &orderBook);
+    }
+  } else if (!dataDirectory.empty()) {
+    OrderBookCatalog catalog{dataDirectory, memoryBudgetMB * 1024 * 1024};
+    merkelBot.run(catalog, wallet, config, strategy);
+    printMemory("after run", nullptr, &catalog);
+  } else if (segmentCount > 1) {
+    MemoryReport::resetHeapPeak();
+    OrderBook orderBook{dataFile, barIntervals};
+    printBars(orderBook);
+    printMemory("after load", &orderBook);
+    ParallelBacktest backtest{segmentCount, warmupTimestamps};
+    const Wallet initialWallet = wallet;
+    backtest.run<Strategy>(orderBook, wallet, config, logFile);
+    // The sequential run goes last, it inserts the bot's orders into the book
+    if (verifySegments) {
+      backtest.verify<Strategy>(orderBook, initialWallet, config,
+                                logFile + ".sequential");
+    }
+    backtest.printReport(std::cout);
+    printMemory("after run", &orderBook);
+  } else {
+    // The peak printed after the load is the load's own
+    MemoryReport::resetHeapPeak();
+    OrderBook orderBook{dataFile, barIntervals};
+    printBars(orderBook);
+    printMemory("after load", &orderBook);
+    hostTuning.pin();
+    merkelBot.run(orderBook, wallet, config, strategy);
+    printMemory("after run", &orderBook);
+  }
+  merkelBot.setSharedBookPublisher(nullptr);
+}
+
+// One line per product and interval: how many bars, and the last of them
+void HeadlessMain::printBars(const OrderBook &orderBook) {
+  const BarBuilder &bars = orderBook.getBars();
+  for (const std::string &product : bars.getProducts()) {
+    for (std::int64_t interval : bars.getIntervals()) {
+      const BarSeries *series = bars.find(product, interval);
+      if (series == nullptr || series->size() == 0) {
+        continue;
+      }
+      std::size_t last = series->size() - 1;
+      std::cout << product << " " << interval / 1000 << "ms bars: "
+                << series->size() << " | last " << Timestamp::fromMicros(series->start[last])
+                << " O " << series->open[last] << " H " << series->high[last]
+                << " L " << series->low[last] << " C " << series->close[last]
+                << " V " << series->volume[last] << std::endl;
+    }
+  }
+}
+
+// The book's structures, or the catalog's loaded days, then the bot's and
+// the wallet's
+void HeadlessMain::printMemory(const std::string &when,
+                               const OrderBook *orderBook,
+                               const OrderBookCatalog *catalog) {
+  if (!memoryReport) {
+    return;
+  }
+  MemoryReport report;
+  std::size_t orders = 0;
+  if (orderBook != nullptr) {
+    orderBook->reportMemory(report);
+    orders = orderBook->getOrderCount();
+  }
+  if (catalog != nullptr) {
+    report.add("loaded days", catalog->getLoadedBytes(),
+               catalog->getLoadedDayCount());
+  }
+  merkelBot.reportMemory(report);
+  report.add("wallet", wallet.getMemoryUsage(), wallet.getBalances().size());
+  report.print(std::cout, "Memory " + when, orders);
+}
+
+int HeadlessMain::run() {
+  if (!parseArguments()) {
+    printUsage();
+    return 1;
+  }
+  if (tuningConfig.hugePages) {
+    HostTuning::restartWithHugePages(arguments);
+  }
+  ProductConfig config = ProductConfig::forProduct(product);
+  if (!config.isValid()) {
+    std::cout << "HeadlessMain unknown product " << product << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (segmentCount > 1 && (!feedSocket.empty() || !dataDirectory.empty() ||
+                           checkpointEvery > 0 || !resumePath.empty() ||
+                           simulateExecution || riskChecks ||
+                           tuningConfig.cpu >= 0)) {
+    std::cout << "HeadlessMain --segments only applies to a plain --data run"
+              << std::endl;
+    printUsage();
+    return 1;
+  }
+  // The days of a catalog are loaded during the run, so their BlockReader
+  // threads would share the bot's core
+  if (!dataDirectory.empty() && tuningConfig.cpu >= 0) {
+    std::cout << "HeadlessMain --cpu does not apply to a --data-dir run"
+              << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  wallet.insertCurrency("BTC", 10);
+  wallet.insertCurrency("USDT", 100000);
+  wallet.insertCurrency("ETH", 50);
+  wallet.insertCurrency("DOGE", 50000);
+  merkelBot.setLogFile(logFile);
+  if (checkpointEvery > 0) {
+    // Created up front, a checkpoint that cannot be written fails the run now
+    std::error_code error;
+    if (!checkpointDirectory.empty()) {
+      std::filesystem::create_directories(checkpointDirectory, error);
+    }
+    if (error) {
+      std::cout << "HeadlessMain cannot create checkpoint directory "
+                << checkpointDirectory << ": " << error.message() << std::endl;
+      return 1;
+    }
+    merkelBot.setCheckpointing(
+        checkpointDirectory.empty() ? "." : checkpointDirectory,
+        checkpointEvery);
+  }
+  if (!resumePath.empty()) {
+    merkelBot.resumeFrom(resumePath);
+  }
+  merkelBot.setOrderPriceOffset(priceOffset);
+  std::unique_ptr<ExecutionSimulator> simulator;
+  if (simulateExecution) {
+    simulator.reset(new ExecutionSimulator{executionConfig});
+    merkelBot.setExecutionSimulator(simulator.get());
+  }
+  RiskEngine risk;
+  if (riskChecks) {
+    risk.setLimits(config.id, riskLimits);
+    merkelBot.setRiskEngine(&risk);
+  }
+
+  // Before the load, so the book's memory is allocated locked. The thread
+  // is only pinned once the book is loaded
+  HostTuning hostTuning{tuningConfig};
+  hostTuning.apply();
+
+  if (strategyName == "ema") {
+    runStrategy<EMACrossoverStrategy>(config, hostTuning);
+  } else if (strategyName == "meanrev") {
+    runStrategy<MeanReversionStrategy>(config, hostTuning);
+  } else if (strategyName == "vwap") {
+    runStrategy<VWAPDeviationStrategy>(config, hostTuning);
+  } else {
+    std::cout << "HeadlessMain unknown strategy " << strategyName << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!feedSocket.empty() || tuningConfig.cpu >= 0 ||
+      tuningConfig.lockMemory || tuningConfig.hugePages) {
+    hostTuning.describe(std::cout);
+  }
+  if (simulator) {
+    merkelBot.setExecutionSimulator(nullptr);
+    simulator->printReport(std::cout);
+  }
+  if (riskChecks) {
+    merkelBot.setRiskEngine(nullptr);
+    risk.printReport(std::cout);
+  }
+  std::cout << "Final wallet" << std::endl;
+  std::cout << wallet.toString() << std::endl;
+  return 0;
+}
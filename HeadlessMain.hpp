@@ -0,0 +1,76 @@
+#pragma once
+
+#include "HostTuning.hpp"
+#include "MerkelBot.hpp"
+#include "ProductConfig.hpp"
+#include "Wallet.hpp"
+#include <string>
+#include <vector>
+
+/** runs the bot from the command line, without the interactive menu:
+ *   merkelbot --bot BTC/USDT [--strategy ema|meanrev|vwap]
+ *             [--data 20200601.csv | --data-dir DIR [--memory-budget MB]]
+ *             [--log output.txt]
+ *   merkelbot --bot BTC/USDT --feed SOCKET   trades live on the mock exchange
+ * --shm NAME also publishes the book to shared memory for other processes.
+ * --checkpoint-dir DIR --checkpoint-every N writes a checkpoint every N
+ * timestamps, --resume FILE starts from one.
+ * --segments K [--warmup N] [--verify] splits a --data replay into K
+ * segments run in parallel, see ParallelBacktest.hpp.
+ * --bars 1s,1m builds bars of a --data file at those intervals as it loads
+ * and prints a summary of them.
+ * --exec-latency-us N [--exec-lifetime-us N] fills orders through the
+ * ExecutionSimulator with that entry latency, --price-offset F prices them
+ * F of the snapshot price through the market (0.1 by default).
+ * --max-position X, --max-notional X, --max-orders N [--rate-window-us W]
+ * and --price-band F set pre-trade limits, see RiskEngine.hpp.
+ * --cpu N pins the bot to a core, --busy-poll spins on the feed socket,
+ * --lock-memory prefaults and locks the process's memory and --huge-pages
+ * backs the heap with huge pages, see HostTuning.hpp.
+ * --memory-report prints where the memory goes once the data is loaded
+ * and again after the run, see MemoryReport.hpp.
+ */
+class HeadlessMain {
+public:
+  HeadlessMain(int argc, char *argv[]);
+  /** true if the command line asks for a headless run */
+  static bool isHeadless(int argc, char *argv[]);
+  /** Call this to run the bot, returns the process exit code */
+  int run();
+
+private:
+  bool parseArguments();
+  void printUsage();
+  template <typename Strategy>
+  void runStrategy(const ProductConfig &config, HostTuning &hostTuning);
+  void printBars(const OrderBook &orderBook);
+  void printMemory(const std::string &when, const OrderBook *orderBook,
+                   const OrderBookCatalog *catalog = nullptr);
+
+  std::vector<std::string> arguments;
+  std::string product;
+  std::string strategyName = "ema";
+  std::string dataFile = "20200601.csv";
+  std::string dataDirectory;
+  std::string feedSocket;
+  std::string sharedBookName;
+  std::string checkpointDirectory;
+  unsigned int checkpointEvery = 0;
+  std::string resumePath;
+  unsigned int segmentCount = 1;
+  unsigned int warmupTimestamps = 200;
+  bool verifySegments = false;
+  std::vector<std::int64_t> barIntervals;
+  bool simulateExecution = false;
+  ExecutionConfig executionConfig;
+  double priceOffset = 0.1;
+  bool riskChecks = false;
+  RiskLimits riskLimits;
+  TuningConfig tuningConfig;
+  bool memoryReport = false;
+  std::size_t memoryBudgetMB = 1024;
+  std::string logFile = "output.txt";
+
+  Wallet wallet;
+  MerkelBot merkelBot;
+};
@@ -0,0 +1,121 @@
+#include "HostTuning.hpp"
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+HostTuning::HostTuning(const TuningConfig &_config) : config(_config) {}
+
+void HostTuning::restartWithHugePages(
+    const std::vector<std::string> &arguments) {
+  const char *tunables = std::getenv("GLIBC_TUNABLES");
+  std::string value = tunables == nullptr ? "" : tunables;
+  // Already restarted, or set by the caller
+  if (value.find("glibc.malloc.hugetlb") != std::string::npos) {
+    return;
+  }
+  // 1: malloc asks for transparent huge pages with madvise(MADV_HUGEPAGE)
+  value = (value.empty() ? "" : value + ":") + "glibc.malloc.hugetlb=1";
+  ::setenv("GLIBC_TUNABLES", value.c_str(), 1);
+  std::vector<char *> argv;
+  argv.push_back(const_cast<char *>("merkelbot"));
+  for (const std::string &arg : arguments) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  ::execv("/proc/self/exe", argv.data());
+  std::cout << "HostTuning cannot restart with huge pages" << std::endl;
+}
+
+void HostTuning::apply() {
+  if (config.lockMemory) {
+    prefaultStack();
+    locked = lockMemory(config.hugePages);
+    if (!locked) {
+      std::cout << "HostTuning cannot lock memory, check ulimit -l"
+                << std::endl;
+    }
+  }
+}
+
+void HostTuning::pin() {
+  if (config.cpu >= 0) {
+    pinned = pinCurrentThread(config.cpu);
+    if (!pinned) {
+      std::cout << "HostTuning cannot pin to cpu " << config.cpu << std::endl;
+    }
+  }
+}
+
+bool HostTuning::pinCurrentThread(int cpu) {
+  if (cpu < 0) {
+    return true;
+  }
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  return ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+// Freed memory stays in the heap to be reused, and the heap grows in large
+// steps, so once locked the run takes no page faults on the book's buckets
+bool HostTuning::lockMemory(bool hugePages) {
+  ::mallopt(M_TRIM_THRESHOLD, INT_MAX);
+  ::mallopt(M_MMAP_MAX, 0);
+  ::mallopt(M_TOP_PAD, 64 * 1024 * 1024);
+  if (!hugePages) {
+    // MCL_FUTURE faults in every mapping made from now on as it is made
+    return ::mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+  }
+  // Faulting the heap in as it grows would do it before malloc asks for
+  // huge pages, in small ones: later mappings are locked page by page as
+  // they are first touched instead
+  return ::mlockall(MCL_CURRENT) == 0 &&
+         ::mlockall(MCL_FUTURE | MCL_ONFAULT) == 0;
+}
+
+// Touches the stack the decision path will use, before it is locked
+void HostTuning::prefaultStack() {
+  volatile char stack[512 * 1024];
+  for (std::size_t i = 0; i < sizeof(stack); i += 4096) {
+    stack[i] = 0;
+  }
+}
+
+std::size_t HostTuning::hugePageBytes() {
+  std::ifstream smaps{"/proc/self/smaps_rollup"};
+  std::string field;
+  std::size_t kilobytes = 0;
+  while (smaps >> field) {
+    if (field == "AnonHugePages:") {
+      smaps >> kilobytes;
+      break;
+    }
+  }
+  return kilobytes * 1024;
+}
+
+void HostTuning::describe(std::ostream &os) const {
+  os << "Host tuning: cpu ";
+  if (config.cpu < 0) {
+    os << "any";
+  } else {
+    os << config.cpu << (pinned ? "" : " (not pinned)");
+  }
+  os << ", " << (config.busyPoll ? "busy-poll" : "epoll wait");
+  if (config.lockMemory) {
+    os << (locked ? ", memory locked" : ", memory not locked");
+  }
+  if (config.hugePages) {
+    os << ", huge pages " << hugePageBytes() / (1024 * 1024) << " MB";
+  }
+  os << std::endl;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/** how the process is laid out on the host for a live run. Everything is
+ * off by default */
+struct TuningConfig {
+  /** core the bot's thread runs on, -1 to let the scheduler move it */
+  int cpu = -1;
+  /** spin on the feed socket instead of sleeping in epoll_wait */
+  bool busyPoll = false;
+  /** fault in and lock every page the process has and will have */
+  bool lockMemory = false;
+  /** back the heap, and so the order book, with transparent huge pages */
+  bool hugePages = false;
+};
+
+/** applies a TuningConfig to the running process (Linux only).
+ * A setting the host refuses is reported and left off, the run goes on
+ * without it: locking needs CAP_IPC_LOCK or a large enough
+ * RLIMIT_MEMLOCK, huge pages need transparent huge pages set to madvise
+ * or always and a glibc that knows the glibc.malloc.hugetlb tunable */
+class HostTuning {
+public:
+  explicit HostTuning(const TuningConfig &_config);
+
+  /** glibc only reads its malloc tunables at startup, so huge pages are
+   * turned on by starting the program again with them set. Returns only
+   * if that is not needed or fails; call it before anything is loaded */
+  static void restartWithHugePages(const std::vector<std::string> &arguments);
+
+  /** lock and prefault memory, before anything is loaded so the book is
+   * allocated locked */
+  void apply();
+  /** pin the calling thread. Threads started afterwards inherit the
+   * pinning, so call it once the book is loaded: the BlockReader thread
+   * that decompresses it then keeps a core of its own */
+  void pin();
+  /** true if the calling thread is on the configured core, or free */
+  static bool pinCurrentThread(int cpu);
+
+  const TuningConfig &getConfig() const { return config; }
+  /** bytes of the heap backed by huge pages right now */
+  static std::size_t hugePageBytes();
+  /** the settings in effect, one line */
+  void describe(std::ostream &os) const;
+
+private:
+  static bool lockMemory(bool hugePages);
+  static void prefaultStack();
+
+  TuningConfig config;
+  bool pinned = false;
+  bool locked = false;
+};
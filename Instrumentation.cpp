@@ -0,0 +1,260 @@
+#include "Instrumentation.hpp"
+#include "MemoryReport.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <malloc.h>
+#include <mutex>
+#include <new>
+
+LatencyHistogram::LatencyHistogram()
+    : buckets((64 - subBucketBits + 1) * subBucketCount, 0), count(0), min(0),
+      max(0), sum(0) {}
+
+// Bucket 0 holds the exact values below subBucketCount. Each following bucket
+// covers one power of two, split in subBucketCount linear sub-buckets.
+unsigned int LatencyHistogram::bucketIndex(std::uint64_t value) {
+  if (value < subBucketCount) {
+    return value;
+  }
+  unsigned int msb = 63 - __builtin_clzll(value);
+  unsigned int shift = msb - subBucketBits;
+  unsigned int mantissa = value >> shift; // in [subBucketCount, 2*subBucketCount)
+  return (shift + 1) * subBucketCount + (mantissa - subBucketCount);
+}
+
+std::uint64_t LatencyHistogram::bucketValue(unsigned int index) {
+  unsigned int bucket = index / subBucketCount;
+  std::uint64_t sub = index % subBucketCount;
+  if (bucket == 0) {
+    return sub;
+  }
+  return (subBucketCount + sub) << (bucket - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t value) {
+  buckets[bucketIndex(value)]++;
+  if (count == 0 || value < min)
+    min = value;
+  if (value > max)
+    max = value;
+  count++;
+  sum += value;
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+  if (count == 0) {
+    return 0;
+  }
+  std::uint64_t rank = fraction * count;
+  if (rank >= count)
+    rank = count - 1;
+  std::uint64_t seen = 0;
+  for (unsigned int i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen > rank) {
+      std::uint64_t value = bucketValue(i);
+      return value > max ? max : value;
+    }
+  }
+  return max;
+}
+
+double LatencyHistogram::getMean() const {
+  return count == 0 ? 0 : sum / count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (unsigned int i = 0; i < buckets.size(); i++) {
+    buckets[i] += other.buckets[i];
+  }
+  if (other.count > 0 && (count == 0 || other.min < min))
+    min = other.min;
+  if (other.max > max)
+    max = other.max;
+  count += other.count;
+  sum += other.sum;
+}
+
+void LatencyHistogram::reset() {
+  std::fill(buckets.begin(), buckets.end(), 0);
+  count = 0;
+  min = 0;
+  max = 0;
+  sum = 0;
+}
+
+namespace {
+std::atomic<std::uint64_t> counters[static_cast<unsigned int>(Counter::count)];
+
+// Several bots may run at once (see ParallelBacktest). Each thread records
+// into its own histograms without locking; the lock only guards the list of
+// them, which changes when a thread records for the first time or ends
+std::mutex histogramsMutex;
+
+std::vector<LatencyHistogram> emptyStages() {
+  return std::vector<LatencyHistogram>(static_cast<unsigned int>(Stage::count));
+}
+
+struct ThreadHistograms;
+
+std::vector<ThreadHistograms *> &liveHistograms() {
+  static std::vector<ThreadHistograms *> live;
+  return live;
+}
+
+// The records of the threads that have ended
+std::vector<LatencyHistogram> &retiredHistograms() {
+  static std::vector<LatencyHistogram> retired = emptyStages();
+  return retired;
+}
+
+struct ThreadHistograms {
+  std::vector<LatencyHistogram> stages = emptyStages();
+
+  ThreadHistograms() {
+    std::lock_guard<std::mutex> lock{histogramsMutex};
+    liveHistograms().push_back(this);
+  }
+  ~ThreadHistograms() {
+    std::lock_guard<std::mutex> lock{histogramsMutex};
+    std::vector<ThreadHistograms *> &live = liveHistograms();
+    live.erase(std::find(live.begin(), live.end(), this));
+    for (unsigned int i = 0; i < stages.size(); i++) {
+      retiredHistograms()[i].merge(stages[i]);
+    }
+  }
+};
+
+ThreadHistograms &threadHistograms() {
+  thread_local ThreadHistograms histograms;
+  return histograms;
+}
+
+// The records of every thread so far, rebuilt on each read
+std::vector<LatencyHistogram> &mergedHistograms() {
+  static std::vector<LatencyHistogram> merged = emptyStages();
+  std::lock_guard<std::mutex> lock{histogramsMutex};
+  merged = retiredHistograms();
+  for (ThreadHistograms *thread : liveHistograms()) {
+    for (unsigned int i = 0; i < merged.size(); i++) {
+      merged[i].merge(thread->stages[i]);
+    }
+  }
+  return merged;
+}
+} // namespace
+
+void Instrumentation::record(Stage stage, std::uint64_t nanos) {
+  threadHistograms().stages[static_cast<unsigned int>(stage)].record(nanos);
+}
+
+void Instrumentation::count(Counter counter, std::uint64_t amount) {
+  counters[static_cast<unsigned int>(counter)].fetch_add(
+      amount, std::memory_order_relaxed);
+}
+
+const LatencyHistogram &Instrumentation::getHistogram(Stage stage) {
+  return mergedHistograms()[static_cast<unsigned int>(stage)];
+}
+
+std::uint64_t Instrumentation::getCounter(Counter counter) {
+  return counters[static_cast<unsigned int>(counter)].load(
+      std::memory_order_relaxed);
+}
+
+void Instrumentation::dump(std::ostream &os) {
+  const std::vector<LatencyHistogram> &histograms = mergedHistograms();
+  os << "Stage latencies (ns)" << std::endl;
+  os << std::left << std::setw(18) << "stage" << std::right << std::setw(10)
+     << "count" << std::setw(12) << "p50" << std::setw(12) << "p99"
+     << std::setw(12) << "p999" << std::setw(12) << "max" << std::endl;
+  for (unsigned int i = 0; i < static_cast<unsigned int>(Stage::count); i++) {
+    const LatencyHistogram &h = histograms[i];
+    os << std::left << std::setw(18) << stageName(static_cast<Stage>(i))
+       << std::right << std::setw(10) << h.getCount() << std::setw(12)
+       << h.percentile(0.5) << std::setw(12) << h.percentile(0.99)
+       << std::setw(12) << h.percentile(0.999) << std::setw(12) << h.getMax()
+       << std::endl;
+  }
+  for (unsigned int i = 0; i < static_cast<unsigned int>(Counter::count);
+       i++) {
+    os << counterName(static_cast<Counter>(i)) << ": "
+       << counters[i].load(std::memory_order_relaxed) << std::endl;
+  }
+}
+
+void Instrumentation::reset() {
+  std::lock_guard<std::mutex> lock{histogramsMutex};
+  for (LatencyHistogram &h : retiredHistograms()) {
+    h.reset();
+  }
+  for (ThreadHistograms *thread : liveHistograms()) {
+    for (LatencyHistogram &h : thread->stages) {
+      h.reset();
+    }
+  }
+  for (std::atomic<std::uint64_t> &c : counters) {
+    c.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::string Instrumentation::stageName(Stage stage) {
+  switch (stage) {
+  case Stage::csvLoad:
+    return "csvLoad";
+  case Stage::getOrders:
+    return "getOrders";
+  case Stage::emaCalculation:
+    return "emaCalculation";
+  case Stage::placeOrder:
+    return "placeOrder";
+  case Stage::matchAsksToBids:
+    return "matchAsksToBids";
+  case Stage::walletUpdate:
+    return "walletUpdate";
+  case Stage::simulateExecution:
+    return "simulateExecution";
+  default:
+    return "unknown";
+  }
+}
+
+std::string Instrumentation::counterName(Counter counter) {
+  switch (counter) {
+  case Counter::orders:
+    return "orders";
+  case Counter::fills:
+    return "fills";
+  case Counter::allocations:
+    return "allocations";
+  default:
+    return "unknown";
+  }
+}
+
+#ifdef MERKEL_INSTRUMENT
+// Every heap allocation of the process is counted, and its bytes go to the
+// heap counters of MemoryReport. The other forms of operator new and delete
+// forward to these, the sized delete to the unsized one.
+void *operator new(std::size_t size) {
+  counters[static_cast<unsigned int>(Counter::allocations)].fetch_add(
+      1, std::memory_order_relaxed);
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc{};
+  }
+  MemoryReport::onAllocate(malloc_usable_size(p));
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  if (p != nullptr) {
+    MemoryReport::onFree(malloc_usable_size(p));
+  }
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+#endif
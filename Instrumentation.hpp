@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/** latency histogram with log-linear buckets, in the style of HDR histograms.
+ * Values below 2^subBucketBits are exact, larger ones are kept within
+ * about 3% of their value. Values are nanoseconds.
+ */
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+  /** record one value */
+  void record(std::uint64_t value);
+  /** value below which the given fraction (0..1) of the records fall */
+  std::uint64_t percentile(double fraction) const;
+  std::uint64_t getCount() const { return count; }
+  std::uint64_t getMin() const { return count == 0 ? 0 : min; }
+  std::uint64_t getMax() const { return max; }
+  double getMean() const;
+  /** add the records of another histogram to this one */
+  void merge(const LatencyHistogram &other);
+  void reset();
+
+private:
+  static const unsigned int subBucketBits = 5;
+  static const unsigned int subBucketCount = 1u << subBucketBits;
+
+  static unsigned int bucketIndex(std::uint64_t value);
+  static std::uint64_t bucketValue(unsigned int index);
+
+  std::vector<std::uint64_t> buckets;
+  std::uint64_t count;
+  std::uint64_t min;
+  std::uint64_t max;
+  double sum;
+};
+
+/** the hot-path stages a bot run is split into */
+enum class Stage {
+  csvLoad,
+  getOrders,
+  emaCalculation,
+  placeOrder,
+  matchAsksToBids,
+  walletUpdate,
+  simulateExecution,
+  count
+};
+
+/** events counted during a run */
+enum class Counter { orders, fills, allocations, count };
+
+/** process wide latency histograms and counters for the hot-path stages.
+ * Only fed through the MERKEL_* macros below, which compile to nothing
+ * unless MERKEL_INSTRUMENT is defined. Each thread records into histograms
+ * of its own, merged when they are read, so read them once the threads
+ * being measured are done.
+ */
+class Instrumentation {
+public:
+  static void record(Stage stage, std::uint64_t nanos);
+  static void count(Counter counter, std::uint64_t amount);
+  static const LatencyHistogram &getHistogram(Stage stage);
+  static std::uint64_t getCounter(Counter counter);
+  /** print count, p50, p99, p999 and max of every stage, then the counters */
+  static void dump(std::ostream &os);
+  static void reset();
+  static std::string stageName(Stage stage);
+  static std::string counterName(Counter counter);
+};
+
+/** times its own lifetime and records it against a stage */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Stage _stage)
+      : stage(_stage), start(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    std::chrono::steady_clock::duration elapsed =
+        std::chrono::steady_clock::now() - start;
+    Instrumentation::record(
+        stage,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Stage stage;
+  std::chrono::steady_clock::time_point start;
+};
+
+#define MERKEL_CONCAT_INNER(a, b) a##b
+#define MERKEL_CONCAT(a, b) MERKEL_CONCAT_INNER(a, b)
+
+#ifdef MERKEL_INSTRUMENT
+#define MERKEL_TIME_STAGE(stage)                                               \
+  ScopedTimer MERKEL_CONCAT(merkelStageTimer, __LINE__) { stage }
+#define MERKEL_COUNT(counter, amount) Instrumentation::count(counter, amount)
+#define MERKEL_DUMP_STATS(os) Instrumentation::dump(os)
+#else
+#define MERKEL_TIME_STAGE(stage)
+#define MERKEL_COUNT(counter, amount)
+#define MERKEL_DUMP_STATS(os)
+#endif
@@ -0,0 +1,49 @@
+#include "MeanReversionStrategy.hpp"
+#include <cmath>
+
+MeanReversionStrategy::MeanReversionStrategy(unsigned int _window,
+                                             double _bandWidth)
+    : window(_window), bandWidth(_bandWidth) {}
+
+void MeanReversionStrategy::saveState(CheckpointWriter &out) const {
+  out.write(window);
+  out.write(bandWidth);
+  out.write(prices);
+  out.write(sum);
+  out.write(sumOfSquares);
+}
+
+void MeanReversionStrategy::loadState(CheckpointReader &in) {
+  in.read(window);
+  in.read(bandWidth);
+  in.read(prices);
+  in.read(sum);
+  in.read(sumOfSquares);
+}
+
+OrderBookType MeanReversionStrategy::onSnapshot(const OrderBookEntry &entry,
+                                                std::ostream &log) {
+  OrderBookType action = OrderBookType::unknown;
+  // The price is only compared once the window is full
+  if (prices.size() == window) {
+    double mean = sum / window;
+    double variance = sumOfSquares / window - mean * mean;
+    double deviation = variance > 0 ? std::sqrt(variance) : 0;
+    log << "meanReversion price " << entry.price << " | mean " << mean
+        << " | deviation " << deviation << std::endl;
+    if (entry.price < mean - bandWidth * deviation) {
+      action = OrderBookType::bid;
+    } else if (entry.price > mean + bandWidth * deviation) {
+      action = OrderBookType::ask;
+    } else {
+      log << "Price is within the band. Bot is sleeping..." << std::endl;
+    }
+    sum -= prices.front();
+    sumOfSquares -= prices.front() * prices.front();
+    prices.pop_front();
+  }
+  prices.push_back(entry.price);
+  sum += entry.price;
+  sumOfSquares += entry.price * entry.price;
+  return action;
+}
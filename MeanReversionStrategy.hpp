@@ -0,0 +1,33 @@
+#pragma once
+
+#include "TradingStrategy.hpp"
+#include <deque>
+
+/** buys when the snapshot price falls a number of standard deviations below
+ * its rolling mean and sells when it rises as far above it */
+class MeanReversionStrategy : public TradingStrategy<MeanReversionStrategy> {
+public:
+  /** window is the number of snapshots the mean is taken over, bandWidth the
+   * number of standard deviations that triggers an order */
+  MeanReversionStrategy(unsigned int window = 20, double bandWidth = 2.0);
+
+  void onEntry(const OrderBookEntry &/*entry*/) {}
+  OrderBookType onSnapshot(const OrderBookEntry &entry, std::ostream &log);
+  void saveState(CheckpointWriter &out) const;
+  void loadState(CheckpointReader &in);
+  static const char *name() { return "meanrev"; }
+  /** libstdc++ keeps a deque of doubles in 512 byte blocks of 64, plus an
+   * array of pointers to them of 8 at least */
+  std::size_t stateMemoryUsage() const {
+    return (prices.size() / 64 + 1) * MemoryReport::heapBlock(512) +
+           MemoryReport::heapBlock(8 * sizeof(double *));
+  }
+
+private:
+  unsigned int window;
+  double bandWidth;
+  std::deque<double> prices;
+  // Running sums over the window, so a snapshot costs O(1)
+  double sum = 0;
+  double sumOfSquares = 0;
+};
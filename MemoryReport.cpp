@@ -0,0 +1,124 @@
+#include "MemoryReport.hpp"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <malloc.h>
+
+namespace {
+// Constant initialised, so they count allocations made before main
+std::atomic<std::size_t> heapBytes{0};
+std::atomic<std::size_t> peakBytes{0};
+
+// Peak resident size from the kernel, in bytes
+std::size_t peakResident() {
+  std::ifstream status{"/proc/self/status"};
+  std::string field;
+  std::size_t kilobytes = 0;
+  while (status >> field) {
+    if (field == "VmHWM:") {
+      status >> kilobytes;
+      break;
+    }
+  }
+  return kilobytes * 1024;
+}
+} // namespace
+
+void MemoryReport::add(const std::string &name, std::size_t bytes,
+                       std::size_t items) {
+  lines.push_back(Line{name, bytes, items});
+}
+
+std::size_t MemoryReport::getTotal() const {
+  std::size_t total = 0;
+  for (const Line &line : lines) {
+    total += line.bytes;
+  }
+  return total;
+}
+
+void MemoryReport::print(std::ostream &os, const std::string &title,
+                         std::size_t orders) const {
+  os << title << " (bytes)" << std::endl;
+  os << std::left << std::setw(24) << "structure" << std::right
+     << std::setw(14) << "bytes" << std::setw(12) << "items" << std::endl;
+  for (const Line &line : lines) {
+    os << std::left << std::setw(24) << line.name << std::right
+       << std::setw(14) << line.bytes << std::setw(12) << line.items
+       << std::endl;
+  }
+  std::size_t total = getTotal();
+  os << std::left << std::setw(24) << "total" << std::right << std::setw(14)
+     << total << std::endl;
+  if (orders > 0) {
+    os << "bytes per order: " << total / orders << " (" << orders
+       << " orders)" << std::endl;
+  }
+  if (isCountingHeap()) {
+    os << "heap in use: " << heapInUse() << " peak: " << heapPeak()
+       << std::endl;
+  } else {
+    os << "heap in use: " << heapInUse()
+       << " peak resident: " << heapPeak() << std::endl;
+  }
+}
+
+// glibc on 64 bits: the request plus an 8 byte header, rounded up to 16,
+// 32 at least
+std::size_t MemoryReport::heapBlock(std::size_t bytes) {
+  if (bytes == 0) {
+    return 0;
+  }
+  std::size_t block = (bytes + 8 + 15) & ~std::size_t{15};
+  return block < 32 ? 32 : block;
+}
+
+std::size_t MemoryReport::stringBytes(const std::string &s) {
+  // The small string buffer of libstdc++ holds 15 characters
+  return s.capacity() > 15 ? heapBlock(s.capacity() + 1) : 0;
+}
+
+bool MemoryReport::isCountingHeap() {
+#ifdef MERKEL_INSTRUMENT
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::size_t MemoryReport::heapInUse() {
+  if (isCountingHeap()) {
+    return heapBytes.load(std::memory_order_relaxed);
+  }
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  struct mallinfo2 info = ::mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+std::size_t MemoryReport::heapPeak() {
+  if (isCountingHeap()) {
+    return peakBytes.load(std::memory_order_relaxed);
+  }
+  return peakResident();
+}
+
+void MemoryReport::resetHeapPeak() {
+  peakBytes.store(heapBytes.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+}
+
+void MemoryReport::onAllocate(std::size_t bytes) {
+  std::size_t now =
+      heapBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  std::size_t peak = peakBytes.load(std::memory_order_relaxed);
+  while (now > peak && !peakBytes.compare_exchange_weak(
+                           peak, now, std::memory_order_relaxed)) {
+  }
+}
+
+void MemoryReport::onFree(std::size_t bytes) {
+  heapBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** where the memory of a run goes, structure by structure.
+ * Each structure adds the heap bytes it holds, estimated from its sizes and
+ * capacities the way glibc malloc rounds blocks, so a report costs a walk
+ * over the structures and no allocator support. Next to it are the heap
+ * counters: in a -DMERKEL_INSTRUMENT build operator new and delete count
+ * the bytes in use and their peak exactly, otherwise they are read from
+ * malloc's own statistics and the peak is the peak resident size */
+class MemoryReport {
+public:
+  /** add a line: `bytes` held by `items` elements of a structure */
+  void add(const std::string &name, std::size_t bytes, std::size_t items = 0);
+  std::size_t getTotal() const;
+  /** a title, the lines and their total, with the bytes per order for
+   * `orders` orders, then the heap counters */
+  void print(std::ostream &os, const std::string &title,
+             std::size_t orders) const;
+
+  /** size of the block malloc hands out for a request of `bytes` */
+  static std::size_t heapBlock(std::size_t bytes);
+  /** heap bytes of a string, 0 when it fits in the string itself */
+  static std::size_t stringBytes(const std::string &s);
+  /** heap bytes of one node of a std::map<Key, Value> */
+  template <typename Key, typename Value> static std::size_t mapNodeBytes() {
+    // The red-black tree node header: colour and three links
+    return heapBlock(4 * sizeof(void *) + sizeof(std::pair<const Key, Value>));
+  }
+  /** heap bytes of the nodes and string keys of a map keyed by strings */
+  template <typename Value>
+  static std::size_t mapBytes(const std::map<std::string, Value> &map) {
+    std::size_t bytes = map.size() * mapNodeBytes<std::string, Value>();
+    for (auto const &entry : map) {
+      bytes += stringBytes(entry.first);
+    }
+    return bytes;
+  }
+
+  /** true if the heap is counted by operator new (MERKEL_INSTRUMENT) */
+  static bool isCountingHeap();
+  /** heap bytes in use right now */
+  static std::size_t heapInUse();
+  /** most heap bytes in use since the last resetHeapPeak, or the peak
+   * resident size of the process when the heap is not counted */
+  static std::size_t heapPeak();
+  /** start a new peak from the bytes in use now */
+  static void resetHeapPeak();
+  /** called by operator new and delete with the size of each block */
+  static void onAllocate(std::size_t bytes);
+  static void onFree(std::size_t bytes);
+
+private:
+  struct Line {
+    std::string name;
+    std::size_t bytes;
+    std::size_t items;
+  };
+
+  std::vector<Line> lines;
+};
@@ -1,37 +1,386 @@
 #pragma once
 
+#include "Checkpoint.hpp"
+#include "ExecutionSimulator.hpp"
+#include "FeedHandler.hpp"
 #include "OrderBook.hpp"
+#include "OrderBookCatalog.hpp"
+#include "OrderGateway.hpp"
+#include "SharedBookPublisher.hpp"
 #include "OrderBookEntry.hpp"
+#include "ProductConfig.hpp"
+#include "RiskEngine.hpp"
 #include "Wallet.hpp"
+#include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <string>
 #include <vector>
 
 class MerkelBot {
 public:
   MerkelBot();
-  /** Call this to start the bot */
-  void init(OrderBook orderBook, Wallet wallet, int input);
+  /** Call this to start the bot on the product and strategy picked in the
+   * bot submenu. Strategy 1 is EMA crossover, 2 mean reversion and 3 VWAP
+   * deviation */
+  void init(OrderBook &orderBook, Wallet &wallet, int input,
+            int strategyInput = 1);
+  /** replay every bid of the configured product through the strategy.
+   * The strategy is a template parameter, see TradingStrategy.hpp */
+  template <typename Strategy>
+  void run(OrderBook &orderBook, Wallet &wallet, const ProductConfig &config,
+           Strategy &strategy);
+  /** replay the days of a catalog one after the other, carrying the
+   * strategy's state across days */
+  template <typename Strategy>
+  void run(OrderBookCatalog &catalog, Wallet &wallet,
+           const ProductConfig &config, Strategy &strategy);
+  /** trade live on the feed: the strategy sees each bucket as soon as the
+   * feed handler has decoded it into the order book */
+  template <typename Strategy>
+  void run(FeedHandler &feed, OrderBook &orderBook, Wallet &wallet,
+           const ProductConfig &config, Strategy &strategy);
+  /** feed the strategy the bids of one timestamp bucket */
+  template <typename Strategy>
+  void step(OrderBook &orderBook, Wallet &wallet, const ProductConfig &config,
+            Strategy &strategy, const std::string &timestamp);
+  /** file the bot logs its operations to, "output.txt" by default */
+  void setLogFile(const std::string &path) { logFile = path; }
+  /** also send every order placed to an exchange, nullptr to stop */
+  void setOrderGateway(OrderGateway *_gateway) { gateway = _gateway; }
+  /** fill orders through the simulator, over the buckets that follow them,
+   * instead of at once against the bucket that triggered them. nullptr to
+   * go back. Its open orders are not part of checkpoints */
+  void setExecutionSimulator(ExecutionSimulator *_simulator) {
+    simulator = _simulator;
+  }
+  /** check every order against the engine's limits before it is placed,
+   * nullptr to stop */
+  void setRiskEngine(RiskEngine *_risk) { risk = _risk; }
+  /** how far through the market orders are priced, as a fraction of the
+   * snapshot price: 0.1 by default, bids at 110% and asks at 90% of it */
+  void setOrderPriceOffset(double offset) { priceOffset = offset; }
+  /** publish the book of every bucket the bot is done with to shared
+   * memory, nullptr to stop */
+  void setSharedBookPublisher(SharedBookPublisher *_publisher) {
+    publisher = _publisher;
+  }
+  /** write a checkpoint into the directory every `every` timestamps the bot
+   * is done with, 0 to stop */
+  void setCheckpointing(const std::string &directory, unsigned int every);
+  /** restore wallet and strategy from a checkpoint at the start of the next
+   * replay, and skip every bid the checkpoint had already processed */
+  void resumeFrom(const std::string &path) { resumePath = path; }
+
+  /** record the sales of every wallet commit that goes through, one group
+   * per commit in the order they were applied, nullptr to stop */
+  void setCommitLog(std::vector<std::vector<OrderBookEntry>> *_commits) {
+    commits = _commits;
+  }
+
+  /** ticks before this timestamp only warm the strategy up, the orders
+   * they lead to are dropped. Empty to trade from the first tick */
+  void setTradingStart(const std::string &timestamp) {
+    tradingStart = timestamp;
+  }
+  /** replay only the bids of the timestamps in [from, to), up to the end of
+   * the book if `to` is empty */
+  void setReplayRange(const std::string &from, const std::string &to) {
+    replayFrom = from;
+    replayTo = to;
+  }
+  /** echo orders, and the stage latencies with MERKEL_INSTRUMENT, to the
+   * console. Off for bots running alongside others */
+  void setConsoleOutput(bool _consoleOutput) { consoleOutput = _consoleOutput; }
+  /** number of orders placed since the bot was created */
+  unsigned int getOrdersPlaced() const { return ordersPlaced; }
+  /** add the state of the last strategy run to a memory report */
+  void reportMemory(MemoryReport &report) const;
+
+  /** write the full bot state at a replay position into a file: wallet,
+   * strategy, counters and the risk engine's state when there is one */
+  template <typename Strategy>
+  bool writeCheckpoint(const std::string &path, const ProductConfig &config,
+                       const ReplayCursor &cursor, const Wallet &wallet,
+                       const Strategy &strategy) const;
+  /** read back a checkpoint written for the same product and strategy */
+  template <typename Strategy>
+  bool readCheckpoint(const std::string &path, const ProductConfig &config,
+                      ReplayCursor &cursor, Wallet &wallet,
+                      Strategy &strategy);
 
 private:
-  void calculateEMA(OrderBook orderBook, Wallet wallet, OrderBookEntry entry);
-  void placeOrder(OrderBook orderBook, Wallet wallet, OrderBookType type,
-                OrderBookEntry entry);
-  void calculateMA(OrderBookEntry entry);
+  void publishBucket(OrderBook &orderBook, const std::string &timestamp);
+  void settleFills(OrderBook &orderBook, Wallet &wallet,
+                   const ProductConfig &config, const std::string &timestamp);
+  bool passesRisk(const OrderBookEntry &obe, const OrderBookEntry &entry,
+                  const ProductConfig &config);
+  template <typename Strategy>
+  bool beginResume(const ProductConfig &config, Wallet &wallet,
+                   Strategy &strategy);
+  template <typename Strategy>
+  void finishBucket(OrderBook &orderBook, const ProductConfig &config,
+                    Wallet &wallet, const Strategy &strategy,
+                    const std::string &timestamp);
+  void openLog(const ProductConfig &config);
+  void closeLog();
+  template <typename Strategy>
+  void replay(OrderBook &orderBook, Wallet &wallet, const ProductConfig &config,
+              Strategy &strategy);
+  void placeOrder(OrderBook &orderBook, Wallet &wallet, OrderBookType type,
+                  const OrderBookEntry &entry, const ProductConfig &config);
   std::string getAction(OrderBookType type);
-  OrderBookEntry buildObe(OrderBookType type, OrderBookEntry entry);
-  float getSuitableAmount(OrderBookEntry entry);
-  std::tuple<int, int> getDeltaThresholds(OrderBookEntry entry);
-
-  std::string currentTime;
-  std::vector<double> movingAverages;
-  double movingAverageAcc = 0;
-  double bidEntriesCounter = 0;
-
-  // The Timestamp counter will be used to keep track of the time "passing" within the orderBook.
-  // The bot will take a snapshot (i.e. will compute the Exponential Moving Average) every 10 snapshots
-  double timestampCounter = 0;
-  // The Snapshot counter will be used within the Exponential Moving Average formula to compute its value
-  double snapshotCounter = 0;
-  std::string currentTimestamp = "";
+  OrderBookEntry buildObe(OrderBookType type, const OrderBookEntry &entry,
+                          const ProductConfig &config);
+
+  std::string logFile = "output.txt";
   std::ofstream logger;
+  OrderGateway *gateway = nullptr;
+  SharedBookPublisher *publisher = nullptr;
+  ExecutionSimulator *simulator = nullptr;
+  std::vector<std::vector<OrderBookEntry>> *commits = nullptr;
+  RiskEngine *risk = nullptr;
+  double priceOffset = 0.1;
+
+  std::string checkpointDirectory;
+  unsigned int checkpointEvery = 0;
+  unsigned int checkpointCount = 0;
+  unsigned int bucketsDone = 0;
+  std::string resumePath;
+  // While resuming, bids up to the cursor are skipped
+  bool resuming = false;
+  ReplayCursor resumeCursor;
+  unsigned int currentDay = 0;
+  std::string tradingStart;
+  unsigned int ordersPlaced = 0;
+  std::string replayFrom;
+  std::string replayTo;
+  bool consoleOutput = true;
+  // The strategy lives only as long as its run, its size is kept at the end
+  std::string lastStrategy;
+  std::size_t strategyBytes = 0;
 };
+
+template <typename Strategy>
+void MerkelBot::run(OrderBook &orderBook, Wallet &wallet,
+                    const ProductConfig &config, Strategy &strategy) {
+  openLog(config);
+  strategy.setup(config);
+  currentDay = 0;
+  if (beginResume(config, wallet, strategy)) {
+    replay(orderBook, wallet, config, strategy);
+  }
+  lastStrategy = Strategy::name();
+  strategyBytes = strategy.getMemoryUsage();
+  closeLog();
+}
+
+template <typename Strategy>
+void MerkelBot::run(OrderBookCatalog &catalog, Wallet &wallet,
+                    const ProductConfig &config, Strategy &strategy) {
+  openLog(config);
+  strategy.setup(config);
+  if (beginResume(config, wallet, strategy)) {
+    for (unsigned int i = 0; i < catalog.getDays().size(); i++) {
+      // Days before the checkpoint are not even loaded
+      if (resuming && i < resumeCursor.day) {
+        continue;
+      }
+      currentDay = i;
+      logger << "Replaying " << catalog.getDays()[i].path << std::endl;
+      replay(catalog.getDay(i), wallet, config, strategy);
+    }
+  }
+  lastStrategy = Strategy::name();
+  strategyBytes = strategy.getMemoryUsage();
+  closeLog();
+}
+
+template <typename Strategy>
+void MerkelBot::run(FeedHandler &feed, OrderBook &orderBook, Wallet &wallet,
+                    const ProductConfig &config, Strategy &strategy) {
+  openLog(config);
+  strategy.setup(config);
+  feed.run(orderBook, [&](const std::string &timestamp) {
+    step(orderBook, wallet, config, strategy, timestamp);
+  });
+  lastStrategy = Strategy::name();
+  strategyBytes = strategy.getMemoryUsage();
+  closeLog();
+}
+
+template <typename Strategy>
+void MerkelBot::step(OrderBook &orderBook, Wallet &wallet,
+                     const ProductConfig &config, Strategy &strategy,
+                     const std::string &timestamp) {
+  std::vector<OrderBookEntry> bidEntries =
+      orderBook.getOrders(OrderBookType::bid, config.product, timestamp);
+  for (const OrderBookEntry &entry : bidEntries) {
+    OrderBookType action = strategy.onTick(entry, logger);
+    if (action != OrderBookType::unknown && entry.timestamp >= tradingStart) {
+      placeOrder(orderBook, wallet, action, entry, config);
+    }
+  }
+  finishBucket(orderBook, config, wallet, strategy, timestamp);
+}
+
+template <typename Strategy>
+void MerkelBot::replay(OrderBook &orderBook, Wallet &wallet,
+                       const ProductConfig &config, Strategy &strategy) {
+  // The strategies work on the bids of the product that was chosen by the user
+  std::vector<OrderBookEntry> bidEntries = orderBook.getOrdersByTypeAndProduct(
+      OrderBookType::bid, config.product, replayFrom, replayTo);
+
+  // We cycle over all of the orderBook entries of type bid, and let the strategy decide on each of them
+  for (unsigned int i = 0; i < bidEntries.size(); i++) {
+    const OrderBookEntry &entry = bidEntries[i];
+    if (resuming) {
+      // Everything up to the checkpoint's timestamp was processed before it was written
+      if (currentDay == resumeCursor.day &&
+          entry.timestamp <= resumeCursor.timestamp) {
+        continue;
+      }
+      resuming = false;
+    }
+    OrderBookType action = strategy.onTick(entry, logger);
+    if (action != OrderBookType::unknown && entry.timestamp >= tradingStart) {
+      placeOrder(orderBook, wallet, action, entry, config);
+    }
+    // The bucket is done once the next bid belongs to another timestamp
+    if (i + 1 == bidEntries.size() ||
+        bidEntries[i + 1].timestamp != entry.timestamp) {
+      finishBucket(orderBook, config, wallet, strategy, entry.timestamp);
+    }
+  }
+}
+
+template <typename Strategy>
+void MerkelBot::finishBucket(OrderBook &orderBook, const ProductConfig &config,
+                             Wallet &wallet, const Strategy &strategy,
+                             const std::string &timestamp) {
+  settleFills(orderBook, wallet, config, timestamp);
+  publishBucket(orderBook, timestamp);
+  bucketsDone++;
+  if (checkpointEvery == 0 || bucketsDone % checkpointEvery != 0) {
+    return;
+  }
+  ReplayCursor cursor;
+  cursor.day = currentDay;
+  cursor.timestamp = timestamp;
+  std::string number = std::to_string(++checkpointCount);
+  std::string path = checkpointDirectory + "/checkpoint_" +
+                     std::string(6 - std::min<std::size_t>(6, number.size()), '0') +
+                     number + ".bin";
+  if (writeCheckpoint(path, config, cursor, wallet, strategy)) {
+    logger << "Checkpoint " << path << " written at " << timestamp
+           << std::endl;
+  } else {
+    logger << "Checkpoint " << path << " could not be written" << std::endl;
+  }
+}
+
+template <typename Strategy>
+bool MerkelBot::beginResume(const ProductConfig &config, Wallet &wallet,
+                            Strategy &strategy) {
+  bucketsDone = 0;
+  resuming = false;
+  if (resumePath.empty()) {
+    return true;
+  }
+  std::string path = resumePath;
+  resumePath.clear();
+  if (!readCheckpoint(path, config, resumeCursor, wallet, strategy)) {
+    logger << "Cannot resume from checkpoint " << path << std::endl;
+    std::cout << "MerkelBot cannot resume from checkpoint " << path
+              << std::endl;
+    return false;
+  }
+  logger << "Resuming from checkpoint " << path << " after "
+         << resumeCursor.timestamp << std::endl;
+  resuming = true;
+  return true;
+}
+
+template <typename Strategy>
+bool MerkelBot::writeCheckpoint(const std::string &path,
+                                const ProductConfig &config,
+                                const ReplayCursor &cursor,
+                                const Wallet &wallet,
+                                const Strategy &strategy) const {
+  CheckpointWriter out;
+  out.write(checkpointMagic);
+  out.write(checkpointVersion);
+  out.write(std::string{Strategy::name()});
+  out.write(config.product);
+  out.write(cursor.day);
+  out.write(cursor.timestamp);
+  // The numbering carries on after a resume instead of starting again at 1
+  out.write(checkpointCount);
+  out.write(bucketsDone);
+  out.write(ordersPlaced);
+  wallet.save(out);
+  strategy.save(out);
+  out.write(risk != nullptr);
+  if (risk != nullptr) {
+    risk->save(out);
+  }
+  return out.saveTo(path);
+}
+
+template <typename Strategy>
+bool MerkelBot::readCheckpoint(const std::string &path,
+                               const ProductConfig &config,
+                               ReplayCursor &cursor, Wallet &wallet,
+                               Strategy &strategy) {
+  CheckpointReader in;
+  if (!in.loadFrom(path)) {
+    return false;
+  }
+  try {
+    std::uint32_t magic, version;
+    std::string strategyName, product;
+    in.read(magic);
+    in.read(version);
+    in.read(strategyName);
+    in.read(product);
+    if (magic != checkpointMagic || version != checkpointVersion ||
+        strategyName != Strategy::name() || product != config.product) {
+      return false;
+    }
+    // Everything is read into copies first, so a truncated file changes nothing
+    ReplayCursor readCursor;
+    Wallet readWallet = wallet;
+    Strategy readStrategy = strategy;
+    unsigned int readCheckpointCount, readBucketsDone, readOrdersPlaced;
+    bool hasRisk;
+    in.read(readCursor.day);
+    in.read(readCursor.timestamp);
+    in.read(readCheckpointCount);
+    in.read(readBucketsDone);
+    in.read(readOrdersPlaced);
+    readWallet.load(in);
+    readStrategy.load(in);
+    in.read(hasRisk);
+    // A run without risk checks ignores the saved state, one with them and
+    // no saved state starts flat
+    RiskEngine readRisk;
+    if (risk != nullptr) {
+      readRisk = *risk;
+    }
+    if (hasRisk) {
+      readRisk.load(in);
+    }
+    cursor = readCursor;
+    checkpointCount = readCheckpointCount;
+    bucketsDone = readBucketsDone;
+    ordersPlaced = readOrdersPlaced;
+    wallet = readWallet;
+    strategy = readStrategy;
+    if (risk != nullptr && hasRisk) {
+      *risk = readRisk;
+    }
+  } catch (const std::exception &e) {
+    return false;
+  }
+  return true;
+}
@@ -1,7 +1,9 @@
 #include "CSVReader.hpp"
 #include "MerkelMain.hpp"
 #include "OrderBookEntry.hpp"
+#include "ProductRegistry.hpp"
 #include <iostream>
+#include <utility>
 #include <vector>
 
 MerkelMain::MerkelMain() {}
@@ -37,6 +39,8 @@ void MerkelMain::printMenu() {
   std::cout << "6: Print wallet " << std::endl;
   // 6 continue
   std::cout << "7: Continue " << std::endl;
+  // 7 print memory usage
+  std::cout << "8: Print memory usage " << std::endl;
 
   std::cout << "============== " << std::endl;
 
@@ -44,26 +48,38 @@ void MerkelMain::printMenu() {
 }
 
 void MerkelMain::printBotSubmenu() {
-  // 1 print btc/usdt
-  std::cout << "1: Automate BTC/USDT trades " << std::endl;
-  // 2 print eth/btc
-  std::cout << "2: Automate ETH/BTC trades " << std::endl;
-  // 3 print doge/btc
-  std::cout << "3: Automate DOGE/BTC trades " << std::endl;
+  // One option per product of the registry, in its order
+  for (std::size_t i = 0; i < productCount; i++) {
+    std::cout << i + 1 << ": Automate " << productSpecs[i].symbol
+              << " trades " << std::endl;
+  }
 
   std::cout << "Current time is: " << currentTime << std::endl;
 }
 
+void MerkelMain::printStrategySubmenu() {
+  // 1 print ema crossover
+  std::cout << "1: EMA crossover " << std::endl;
+  // 2 print mean reversion
+  std::cout << "2: Mean reversion " << std::endl;
+  // 3 print vwap deviation
+  std::cout << "3: VWAP deviation " << std::endl;
+}
+
 void MerkelMain::startBot() {
   std::cout << "Select product to automate" << std::endl;
   int input;
+  int strategyInput;
 
   while (true) {
     printBotSubmenu();
-    input = getUserOption();
+    input = getUserBotSubmenuOption(productCount);
+    std::cout << "Select strategy" << std::endl;
+    printStrategySubmenu();
+    strategyInput = getUserBotSubmenuOption(3);
     std::cout << "The Trading Bot is starting..." << std::endl;
 
-    merkelBot.init(orderBook, wallet, input);
+    merkelBot.init(orderBook, wallet, input, strategyInput);
   }
 }
 
@@ -76,11 +92,10 @@ void MerkelMain::printHelp() {
 void MerkelMain::printMarketStats() {
   for (std::string const &p : orderBook.getKnownProducts()) {
     std::cout << "Product: " << p << std::endl;
-    std::vector<OrderBookEntry> entries =
-        orderBook.getOrders(OrderBookType::ask, p, currentTime);
-    std::cout << "Asks seen: " << entries.size() << std::endl;
-    std::cout << "Max ask: " << OrderBook::getHighPrice(entries) << std::endl;
-    std::cout << "Min ask: " << OrderBook::getLowPrice(entries) << std::endl;
+    const BookSnapshot &snapshot = orderBook.getSnapshot(p, currentTime);
+    std::cout << "Asks seen: " << snapshot.askCount << std::endl;
+    std::cout << "Max ask: " << snapshot.maxAsk << std::endl;
+    std::cout << "Min ask: " << snapshot.minAsk << std::endl;
   }
   // std::cout << "OrderBook contains :  " << orders.size() << " entries" <<
   // std::endl; unsigned int bids = 0; unsigned int asks = 0; for
@@ -98,6 +113,15 @@ void MerkelMain::printMarketStats() {
   // std::cout << "OrderBook asks:  " << asks << " bids:" << bids << std::endl;
 }
 
+// The book, the strategy of the last bot run and the wallet
+void MerkelMain::printMemoryUsage() {
+  MemoryReport report;
+  orderBook.reportMemory(report);
+  merkelBot.reportMemory(report);
+  report.add("wallet", wallet.getMemoryUsage(), wallet.getBalances().size());
+  report.print(std::cout, "Memory usage", orderBook.getOrderCount());
+}
+
 void MerkelMain::enterAsk() {
   std::cout << "Make an ask - enter the amount: product,price, amount, eg  "
                "ETH/BTC,200,0.5"
@@ -112,10 +136,10 @@ void MerkelMain::enterAsk() {
     try {
       OrderBookEntry obe = CSVReader::stringsToOBE(
           tokens[1], tokens[2], currentTime, tokens[0], OrderBookType::ask);
-      obe.username = "simuser";
+      obe.accountId = simuserAccount;
       if (wallet.canFulfillOrder(obe)) {
         std::cout << "Wallet looks good. " << std::endl;
-        orderBook.insertOrder(obe);
+        orderBook.insertOrder(std::move(obe));
       } else {
         std::cout << "Wallet has insufficient funds . " << std::endl;
       }
@@ -139,11 +163,11 @@ void MerkelMain::enterBid() {
     try {
       OrderBookEntry obe = CSVReader::stringsToOBE(
           tokens[1], tokens[2], currentTime, tokens[0], OrderBookType::bid);
-      obe.username = "simuser";
+      obe.accountId = simuserAccount;
 
       if (wallet.canFulfillOrder(obe)) {
         std::cout << "Wallet looks good. " << std::endl;
-        orderBook.insertOrder(obe);
+        orderBook.insertOrder(std::move(obe));
       } else {
         std::cout << "Wallet has insufficient funds . " << std::endl;
       }
@@ -162,14 +186,19 @@ void MerkelMain::gotoNextTimeframe() {
     std::vector<OrderBookEntry> sales =
         orderBook.matchAsksToBids(p, currentTime);
     std::cout << "Sales: " << sales.size() << std::endl;
+    WalletTransaction transaction;
     for (OrderBookEntry &sale : sales) {
       std::cout << "Sale price: " << sale.price << " amount " << sale.amount
                 << std::endl;
-      if (sale.username == "simuser") {
-        // update the wallet
-        wallet.processSale(sale);
+      if (sale.accountId == simuserAccount) {
+        transaction.addSale(sale);
       }
     }
+    // update the wallet with all of the user's sales at once
+    if (!transaction.empty() && !wallet.commit(transaction)) {
+      std::cout << "Wallet has insufficient funds for the sales of " << p
+                << std::endl;
+    }
   }
 
   currentTime = orderBook.getNextTime(currentTime);
@@ -179,7 +208,7 @@ int MerkelMain::getUserOption() {
   int userOption = 0;
   std::string line;
   // *bug | This shows also after submenu selection
-  std::cout << "Type in 1-7" << std::endl;
+  std::cout << "Type in 1-8" << std::endl;
   std::getline(std::cin, line);
   try {
     userOption = std::stoi(line);
@@ -190,10 +219,10 @@ int MerkelMain::getUserOption() {
   return userOption;
 }
 
-int MerkelMain::getUserBotSubmenuOption() {
+int MerkelMain::getUserBotSubmenuOption(int optionCount) {
   int userOption = 0;
   std::string line;
-  std::cout << "Type in 1-3" << std::endl;
+  std::cout << "Type in 1-" << optionCount << std::endl;
   std::getline(std::cin, line);
   try {
     userOption = std::stoi(line);
@@ -226,4 +255,7 @@ void MerkelMain::processUserOption(int userOption) {
   if (userOption == 7) {
     gotoNextTimeframe();
   }
+  if (userOption == 8) {
+    printMemoryUsage();
+  }
 }
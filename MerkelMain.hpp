@@ -15,15 +15,17 @@ public:
 private:
   void printMenu();
   void printBotSubmenu();
+  void printStrategySubmenu();
   void startBot();
   void printHelp();
   void printMarketStats();
   void enterAsk();
   void enterBid();
   void printWallet();
+  void printMemoryUsage();
   void gotoNextTimeframe();
   int getUserOption();
-  int getUserBotSubmenuOption();
+  int getUserBotSubmenuOption(int optionCount);
   void processUserOption(int userOption);
 
   std::string currentTime;
@@ -1,12 +1,25 @@
 #include "OrderBook.hpp"
 #include "CSVReader.hpp"
+#include "Instrumentation.hpp"
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <utility>
+
+OrderBook::OrderBook() {}
 
 /** construct, reading a csv data file */
-OrderBook::OrderBook(std::string filename) {
+OrderBook::OrderBook(std::string filename,
+                     const std::vector<std::int64_t> &barIntervals)
+    : bars(barIntervals) {
+  MERKEL_TIME_STAGE(Stage::csvLoad);
   ordersMap = CSVReader::readCSVMap(filename);
+  // Every bucket is sealed once loaded, so its snapshots and bars are computed here once
+  for (auto const &o : ordersMap) {
+    snapshots[o.first] = BookSnapshot::buildAll(o.second);
+    bars.addBucket(o.first, o.second);
+  }
 }
 
 /** return vector of all know products in the dataset*/
@@ -16,8 +29,7 @@ std::vector<std::string> OrderBook::getKnownProducts() {
   std::map<std::string, bool> prodMap;
 
   for (auto const &o : ordersMap) {
-    std::vector<OrderBookEntry> obeList = o.second;
-    for (OrderBookEntry &e : obeList) {
+    for (const OrderBookEntry &e : o.second) {
       prodMap[e.product] = true;
     }
   }
@@ -38,26 +50,42 @@ std::vector<OrderBookEntry> OrderBook::getOrders(OrderBookType type,
                                                  std::string timestamp) {
   std::vector<OrderBookEntry> orders_sub;
 
-  for (auto const &o : ordersMap) {
-    if (o.first == timestamp) {
-      std::vector<OrderBookEntry> obeList = o.second;
-      for (OrderBookEntry &e : obeList) {
-        if (e.orderType == type && e.product == product) {
-          orders_sub.push_back(e);
-        }
-      }
+  auto bucket = ordersMap.find(timestamp);
+  if (bucket == ordersMap.end()) {
+    return orders_sub;
+  }
+  for (const OrderBookEntry &e : bucket->second) {
+    if (e.orderType == type && e.product == product) {
+      orders_sub.push_back(e);
     }
   }
   return orders_sub;
 }
 
+const std::vector<OrderBookEntry> &
+OrderBook::getBucket(const std::string &timestamp) const {
+  static const std::vector<OrderBookEntry> empty;
+  auto bucket = ordersMap.find(timestamp);
+  return bucket == ordersMap.end() ? empty : bucket->second;
+}
+
 /** return vector of Orders according to type*/
 std::vector<OrderBookEntry>
 OrderBook::getOrdersByTypeAndProduct(OrderBookType type, std::string product) {
+  return getOrdersByTypeAndProduct(type, product, "", "");
+}
+
+std::vector<OrderBookEntry>
+OrderBook::getOrdersByTypeAndProduct(OrderBookType type,
+                                     const std::string &product,
+                                     const std::string &from,
+                                     const std::string &to) const {
+  MERKEL_TIME_STAGE(Stage::getOrders);
   std::vector<OrderBookEntry> orders_sub;
-  for (auto const &o : ordersMap) {
-    std::vector<OrderBookEntry> obeList = o.second;
-    for (OrderBookEntry &e : obeList) {
+  auto first = ordersMap.lower_bound(from);
+  auto last = to.empty() ? ordersMap.end() : ordersMap.lower_bound(to);
+  for (auto o = first; o != last; ++o) {
+    for (const OrderBookEntry &e : o->second) {
       if (e.orderType == type && e.product == product) {
         orders_sub.push_back(e);
       }
@@ -85,50 +113,210 @@ double OrderBook::getLowPrice(std::vector<OrderBookEntry> &orders) {
   return min;
 }
 
-std::string OrderBook::getEarliestTime() { return ordersMap.begin()->first; }
+std::vector<std::string>
+OrderBook::getBidTimestamps(const std::string &product) {
+  std::vector<std::string> timestamps;
+  // The snapshots already know which buckets hold bids of the product
+  for (auto const &s : snapshots) {
+    auto snapshot = s.second.find(product);
+    if (snapshot != s.second.end() && snapshot->second.hasBids()) {
+      timestamps.push_back(s.first);
+    }
+  }
+  return timestamps;
+}
+
+std::string OrderBook::getEarliestTime() {
+  // An empty book has no time, e.g. a day file where no line could be parsed
+  if (ordersMap.empty()) {
+    return "";
+  }
+  return ordersMap.begin()->first;
+}
 
 std::string OrderBook::getNextTime(std::string timestamp) {
-  std::string next_timestamp = "";
-  for (auto const &e : ordersMap) {
-    if (e.first > timestamp) {
-      next_timestamp = timestamp;
-      break;
+  // The buckets are ordered by timestamp, so the next one is found directly
+  auto next = ordersMap.upper_bound(timestamp);
+  if (next == ordersMap.end()) {
+    return getEarliestTime();
+  }
+  return next->first;
+}
+
+std::string OrderBook::getLatestTime() {
+  if (ordersMap.empty()) {
+    return "";
+  }
+  return ordersMap.rbegin()->first;
+}
+
+std::size_t OrderBook::getMemoryUsage() const {
+  MemoryReport report;
+  reportMemory(report);
+  return report.getTotal();
+}
+
+// Split the way capacity planning needs it: the map's nodes and keys, the
+// entries themselves, the strings they own, and what vectors hold unused
+void OrderBook::reportMemory(MemoryReport &report) const {
+  std::size_t entries = 0;
+  std::size_t entryBytes = 0;
+  std::size_t stringsBytes = 0;
+  std::size_t slackBytes = 0;
+  std::size_t keyBytes = 0;
+  for (auto const &o : ordersMap) {
+    keyBytes += MemoryReport::stringBytes(o.first);
+    entries += o.second.size();
+    entryBytes += o.second.size() * sizeof(OrderBookEntry);
+    std::size_t block =
+        MemoryReport::heapBlock(o.second.capacity() * sizeof(OrderBookEntry));
+    slackBytes += block - o.second.size() * sizeof(OrderBookEntry);
+    for (const OrderBookEntry &e : o.second) {
+      stringsBytes += MemoryReport::stringBytes(e.timestamp) +
+                      MemoryReport::stringBytes(e.product);
     }
   }
+  report.add("order map nodes",
+             ordersMap.size() *
+                 MemoryReport::mapNodeBytes<std::string,
+                                            std::vector<OrderBookEntry>>(),
+             ordersMap.size());
+  report.add("timestamp keys", keyBytes, ordersMap.size());
+  report.add("order entries", entryBytes, entries);
+  report.add("entry strings", stringsBytes, entries);
+  report.add("bucket slack", slackBytes, ordersMap.size());
 
-  if (next_timestamp == "") {
-    next_timestamp = orders[0].timestamp;
+  std::size_t snapshotBytes = MemoryReport::mapBytes(snapshots);
+  std::size_t snapshotCount = 0;
+  for (auto const &t : snapshots) {
+    snapshotBytes += MemoryReport::mapBytes(t.second);
+    for (auto const &p : t.second) {
+      snapshotBytes +=
+          MemoryReport::heapBlock(p.second.askDepth.capacity() *
+                                  sizeof(DepthLevel)) +
+          MemoryReport::heapBlock(p.second.bidDepth.capacity() *
+                                  sizeof(DepthLevel));
+      snapshotCount++;
+    }
+  }
+  report.add("snapshots", snapshotBytes, snapshotCount);
+  report.add("bars", bars.getMemoryUsage());
+}
+
+std::size_t OrderBook::getOrderCount() const {
+  std::size_t count = 0;
+  for (auto const &o : ordersMap) {
+    count += o.second.size();
   }
-  return next_timestamp;
+  return count;
 }
 
 // This function has been edited to reflect the speed optimizations
 // It will now select the map element (which is a vector) by its timestamp, and then push the order in the vector
-void OrderBook::insertOrder(OrderBookEntry &order) {
+void OrderBook::insertOrder(const OrderBookEntry &order) {
+  MERKEL_COUNT(Counter::orders, 1);
   ordersMap[order.timestamp].push_back(order);
+  // Keep the cached snapshot in step with the bucket instead of rebuilding it
+  snapshots[order.timestamp][order.product].apply(order);
+}
+
+void OrderBook::insertOrder(OrderBookEntry &&order) {
+  MERKEL_COUNT(Counter::orders, 1);
+  snapshots[order.timestamp][order.product].apply(order);
+  std::vector<OrderBookEntry> &bucket = ordersMap[order.timestamp];
+  bucket.push_back(std::move(order));
 }
 
 // This function has been created in order the withdraw an order that doesn't meet our criteria
 // It optimizes the order research by reducing it to the appropriate vector only i.e. the vector that corresponds to the relevant timestamp
 void OrderBook::removeOrder(OrderBookEntry &order) {
   // The correct vector is selected
-  std::vector<OrderBookEntry> timestampOrders = ordersMap[order.timestamp];
-  // We iterate an all vector elements and we remove any orders that have been placed by the bot user
-  for (int i = 0; i < timestampOrders.size(); i++) {
-    // Condition for finding the bot orders and leaving the rest out
-    if (timestampOrders[i].username == "bot") {
-      // Erase the element by passing the first element of the vector and the current iterating poistion
-      timestampOrders.erase(timestampOrders.begin() + i);
+  std::vector<OrderBookEntry> &timestampOrders = ordersMap[order.timestamp];
+  // Only the latest entry equal to the order is removed, the dataset orders of the bucket stay as they were
+  for (auto it = timestampOrders.rbegin(); it != timestampOrders.rend(); ++it) {
+    if (it->accountId == order.accountId && it->product == order.product &&
+        it->orderType == order.orderType && it->price == order.price &&
+        it->amount == order.amount) {
+      timestampOrders.erase(std::next(it).base());
+      // Snapshots cannot be updated by removal, so the bucket's ones are rebuilt
+      snapshots[order.timestamp] = BookSnapshot::buildAll(timestampOrders);
+      return;
     }
   }
 }
 
+const BookSnapshot &OrderBook::getSnapshot(std::string const &product,
+                                           std::string const &timestamp) {
+  static const BookSnapshot empty;
+  auto bucket = snapshots.find(timestamp);
+  if (bucket == snapshots.end()) {
+    return empty;
+  }
+  auto snapshot = bucket->second.find(product);
+  if (snapshot == bucket->second.end()) {
+    return empty;
+  }
+  return snapshot->second;
+}
+
+const std::map<std::string, BookSnapshot> &
+OrderBook::getSnapshots(std::string const &timestamp) {
+  static const std::map<std::string, BookSnapshot> empty;
+  auto bucket = snapshots.find(timestamp);
+  return bucket == snapshots.end() ? empty : bucket->second;
+}
+
 std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
                                                        std::string timestamp) {
+  MERKEL_TIME_STAGE(Stage::matchAsksToBids);
   std::vector<OrderBookEntry> asks =
       getOrders(OrderBookType::ask, product, timestamp);
   std::vector<OrderBookEntry> bids =
       getOrders(OrderBookType::bid, product, timestamp);
+  return matchOrders(asks, bids, getSnapshot(product, timestamp), product,
+                     timestamp);
+}
+
+std::vector<OrderBookEntry>
+OrderBook::matchAsksToBids(const OrderBookEntry &order) const {
+  MERKEL_TIME_STAGE(Stage::matchAsksToBids);
+  // The orders getOrders would give once the order is appended to its bucket
+  std::vector<OrderBookEntry> asks;
+  std::vector<OrderBookEntry> bids;
+  for (const OrderBookEntry &e : getBucket(order.timestamp)) {
+    if (e.product != order.product) {
+      continue;
+    }
+    if (e.orderType == OrderBookType::ask) {
+      asks.push_back(e);
+    } else if (e.orderType == OrderBookType::bid) {
+      bids.push_back(e);
+    }
+  }
+  if (order.orderType == OrderBookType::ask) {
+    asks.push_back(order);
+  } else if (order.orderType == OrderBookType::bid) {
+    bids.push_back(order);
+  }
+  // And the snapshot insertOrder would leave
+  BookSnapshot snapshot;
+  auto bucket = snapshots.find(order.timestamp);
+  if (bucket != snapshots.end()) {
+    auto found = bucket->second.find(order.product);
+    if (found != bucket->second.end()) {
+      snapshot = found->second;
+    }
+  }
+  snapshot.apply(order);
+  return matchOrders(asks, bids, snapshot, order.product, order.timestamp);
+}
+
+std::vector<OrderBookEntry>
+OrderBook::matchOrders(std::vector<OrderBookEntry> &asks,
+                       std::vector<OrderBookEntry> &bids,
+                       const BookSnapshot &snapshot,
+                       const std::string &product,
+                       const std::string &timestamp) {
   std::vector<OrderBookEntry> sales;
 
   // I put in a little check to ensure we have bids and asks
@@ -149,14 +337,11 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
               return e1.price > e2.price;
             });
 
-  // This string will take into account which was the context of each transaction 
-  // and then storing it into the sale itself
-  
-  std::string controlString =
-      "max ask: " + std::to_string(asks[asks.size() - 1].price) +
-      " | min ask: " + std::to_string(asks[0].price) +
-      " | max bid: " + std::to_string(bids[0].price) +
-      " | min bid: " + std::to_string(bids[bids.size() - 1].price);
+  // The context of each transaction is stored into the sale itself
+  // It is kept as plain numbers read from the cached snapshot, and only turned
+  // into text if somebody logs it
+  SaleContext context{snapshot.maxAsk, snapshot.minAsk, snapshot.maxBid,
+                      snapshot.minBid};
 
   // for ask in asks:
   for (OrderBookEntry &ask : asks) {
@@ -170,14 +355,18 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
 
       OrderBookEntry sale{ask.price, 0, timestamp, product,
                           OrderBookType::asksale};
-      sale.controlString = controlString;
+      sale.context = context;
 
-      if (bid.username == "simuser" || bid.username == "bot") {
-        sale.username = bid.username;
+      // Fills are attributed to the accounts behind the orders, the ask's
+      // owner takes the sale when both sides are accounts
+      if (bid.accountId != datasetAccount) {
+        sale.accountId = bid.accountId;
+        sale.counterpartyId = ask.accountId;
         sale.orderType = OrderBookType::bidsale;
       }
-      if (ask.username == "simuser" || ask.username == "bot") {
-        sale.username = ask.username;
+      if (ask.accountId != datasetAccount) {
+        sale.accountId = ask.accountId;
+        sale.counterpartyId = bid.accountId;
         sale.orderType = OrderBookType::asksale;
       }
 
@@ -190,7 +379,7 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
         // Our amount is the full ask amount
         sale.amount = ask.amount;
         // sales.append(sale)
-        sales.push_back(sale);
+        sales.push_back(std::move(sale));
         // bid.amount = 0 # make sure the bid is not processed
         // again
         bid.amount = 0;
@@ -207,7 +396,7 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
         // Our amount is the full ask amount
         sale.amount = ask.amount;
         // sales.append(sale)
-        sales.push_back(sale);
+        sales.push_back(std::move(sale));
         // # we adjust the bid in place
         // # so it can be used to process the next ask
         // bid.amount = bid.amount - ask.amount
@@ -225,7 +414,7 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
         // We are selling at the bid price
         sale.amount = bid.amount;
         // sales.append(sale)
-        sales.push_back(sale);
+        sales.push_back(std::move(sale));
         // # update the ask
         // # and allow further bids to process the remaining
         // amount ask.amount = ask.amount - bid.amount
@@ -239,5 +428,98 @@ std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product,
       }
     }
   }
+  MERKEL_COUNT(Counter::fills, sales.size());
+  return sales;
+}
+
+// Follows matchAsksToBids step by step. The orders are sorted with the same
+// std::sort and comparisons, so orders at equal prices end up in the same
+// order as there. An ask can only fill against the first live bid: bids are
+// sorted by descending price, so if that one is too cheap all the others
+// are too, and a bid once emptied is never filled again. A cursor over the
+// live bids replaces the scan from the top of the bids for every ask
+std::vector<OrderBookEntry>
+OrderBook::matchAsksToBidsFast(const std::string &product,
+                               const std::string &timestamp) {
+  std::vector<MatchOrder> asks;
+  std::vector<MatchOrder> bids;
+  for (const OrderBookEntry &e : getBucket(timestamp)) {
+    if (e.product != product) {
+      continue;
+    }
+    if (e.orderType == OrderBookType::ask) {
+      asks.push_back(MatchOrder{e.price, e.amount, e.accountId});
+    } else if (e.orderType == OrderBookType::bid) {
+      bids.push_back(MatchOrder{e.price, e.amount, e.accountId});
+    }
+  }
+  std::vector<OrderBookEntry> sales;
+  // A one-sided book is routine on the hot path, so nothing is printed
+  if (asks.size() == 0 || bids.size() == 0) {
+    return sales;
+  }
+
+  std::sort(asks.begin(), asks.end(),
+            [](const MatchOrder &e1, const MatchOrder &e2) {
+              return e1.price < e2.price;
+            });
+  std::sort(bids.begin(), bids.end(),
+            [](const MatchOrder &e1, const MatchOrder &e2) {
+              return e1.price > e2.price;
+            });
+
+  const BookSnapshot &snapshot = getSnapshot(product, timestamp);
+  SaleContext context{snapshot.maxAsk, snapshot.minAsk, snapshot.maxBid,
+                      snapshot.minBid};
+
+  std::size_t live = 0;
+  for (MatchOrder &ask : asks) {
+    while (true) {
+      // The reference skips bids without a positive amount, NaN included
+      while (live < bids.size() && !(bids[live].amount > 0)) {
+        live++;
+      }
+      if (live == bids.size() || bids[live].price < ask.price) {
+        break;
+      }
+      MatchOrder &bid = bids[live];
+      OrderBookEntry sale{ask.price, 0, timestamp, product,
+                          OrderBookType::asksale};
+      sale.context = context;
+      if (bid.accountId != datasetAccount) {
+        sale.accountId = bid.accountId;
+        sale.counterpartyId = ask.accountId;
+        sale.orderType = OrderBookType::bidsale;
+      }
+      if (ask.accountId != datasetAccount) {
+        sale.accountId = ask.accountId;
+        sale.counterpartyId = bid.accountId;
+        sale.orderType = OrderBookType::asksale;
+      }
+
+      if (bid.amount == ask.amount) {
+        sale.amount = ask.amount;
+        sales.push_back(std::move(sale));
+        bid.amount = 0;
+        break;
+      }
+      if (bid.amount > ask.amount) {
+        sale.amount = ask.amount;
+        sales.push_back(std::move(sale));
+        bid.amount = bid.amount - ask.amount;
+        break;
+      }
+      if (bid.amount < ask.amount) {
+        // The bid is used up, the rest of the ask goes to the next one
+        sale.amount = bid.amount;
+        sales.push_back(std::move(sale));
+        ask.amount = ask.amount - bid.amount;
+        bid.amount = 0;
+        continue;
+      }
+      // A NaN ask amount compares false with every bid and fills nothing
+      break;
+    }
+  }
   return sales;
 }
@@ -1,38 +1,87 @@
 #pragma once
+#include "BarBuilder.hpp"
+#include "BookSnapshot.hpp"
 #include "CSVReader.hpp"
+#include "MemoryReport.hpp"
 #include "OrderBookEntry.hpp"
 #include <string>
 #include <vector>
 
 class OrderBook {
 public:
-  /** construct, reading a csv data file */
-  OrderBook(std::string filename);
+  /** construct an empty book, filled through insertOrder */
+  OrderBook();
+  /** construct, reading a csv data file. Bars of every product are built
+   * while it loads, at each of the intervals given in microseconds */
+  OrderBook(std::string filename,
+            const std::vector<std::int64_t> &barIntervals = {});
   /** return vector of all know products in the dataset*/
   std::vector<std::string> getKnownProducts();
   /** return vector of Orders according to the sent filters*/
   std::vector<OrderBookEntry> getOrders(OrderBookType type, std::string product,
                                         std::string timestamp);
+  /** every order at a timestamp, without copying them. Empty if there are
+   * none */
+  const std::vector<OrderBookEntry> &
+  getBucket(const std::string &timestamp) const;
   /** return vector of Orders according to the sent filters*/
   std::vector<OrderBookEntry> getOrdersByTypeAndProduct(OrderBookType type,
                                                         std::string product);
+  /** the same, for the timestamps in [from, to), up to the end if `to` is
+   * empty */
+  std::vector<OrderBookEntry>
+  getOrdersByTypeAndProduct(OrderBookType type, const std::string &product,
+                            const std::string &from,
+                            const std::string &to) const;
 
-  /** returns the earliest time in the orderbook*/
+  /** timestamps at which the product has bids, in order */
+  std::vector<std::string> getBidTimestamps(const std::string &product);
+
+  /** returns the earliest time in the orderbook, empty if it has no orders*/
   std::string getEarliestTime();
   /** returns the next time after the
    * sent time in the orderbook
    * If there is no next timestamp, wraps around to the start
    * */
   std::string getNextTime(std::string timestamp);
+  /** returns the latest time in the orderbook, empty if it has no orders*/
+  std::string getLatestTime();
+  /** heap bytes held by the book, the total of reportMemory */
+  std::size_t getMemoryUsage() const;
+  /** add the book's structures to a memory report, one line each */
+  void reportMemory(MemoryReport &report) const;
+  /** number of orders in the book */
+  std::size_t getOrderCount() const;
   /** insert order in orderbookentry */
-  void insertOrder(OrderBookEntry &order);
+  void insertOrder(const OrderBookEntry &order);
+  /** insert order in orderbookentry, moving it into the bucket */
+  void insertOrder(OrderBookEntry &&order);
   /** remove order from orderbookentry */
   void removeOrder(OrderBookEntry &order);
   /** get the overall size of the orders vector */
   int getOrdersSize();
 
+  /** cached top-of-book and depth of a product at a timestamp */
+  const BookSnapshot &getSnapshot(std::string const &product,
+                                  std::string const &timestamp);
+  /** cached snapshots of every product at a timestamp */
+  const std::map<std::string, BookSnapshot> &
+  getSnapshots(std::string const &timestamp);
+
+  /** bars built from the csv data when the book was loaded. Orders inserted
+   * afterwards are not in them */
+  const BarBuilder &getBars() const { return bars; }
+
   std::vector<OrderBookEntry> matchAsksToBids(std::string product,
                                               std::string timestamp);
+  /** the fills matchAsksToBids gives once the order is inserted, without
+   * inserting it. The book is only read, so threads can share it */
+  std::vector<OrderBookEntry> matchAsksToBids(const OrderBookEntry &order) const;
+  /** the same fills as matchAsksToBids, which stays the reference, from
+   * lightweight copies of the orders and a single pass over the bids.
+   * tools/match_diff.cpp checks the two against each other */
+  std::vector<OrderBookEntry> matchAsksToBidsFast(const std::string &product,
+                                                  const std::string &timestamp);
 
   /** get the highest price in the registry */
   static double getHighPrice(std::vector<OrderBookEntry> &orders);
@@ -40,6 +89,23 @@ public:
   static double getLowPrice(std::vector<OrderBookEntry> &orders);
 
 private:
+  // What matching needs of an order
+  struct MatchOrder {
+    double price;
+    double amount;
+    AccountId accountId;
+  };
+
+  // The matching of matchAsksToBids, on the orders of one product and
+  // timestamp, in bucket order
+  static std::vector<OrderBookEntry>
+  matchOrders(std::vector<OrderBookEntry> &asks,
+              std::vector<OrderBookEntry> &bids, const BookSnapshot &snapshot,
+              const std::string &product, const std::string &timestamp);
+
   std::vector<OrderBookEntry> orders;
   std::map<std::string, std::vector<OrderBookEntry>> ordersMap;
+  // Snapshots are keyed by timestamp, then by product
+  std::map<std::string, std::map<std::string, BookSnapshot>> snapshots;
+  BarBuilder bars;
 };
@@ -0,0 +1,172 @@
+#include "OrderBookCatalog.hpp"
+#include "BlockReader.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+OrderBookCatalog::OrderBookCatalog(const std::string &directory,
+                                   std::size_t _memoryBudget)
+    : memoryBudget(_memoryBudget), loadedBytes(0) {
+  std::error_code error;
+  for (const std::filesystem::directory_entry &entry :
+       std::filesystem::directory_iterator(directory, error)) {
+    if (!entry.is_regular_file() || !isDayFile(entry.path().filename().string())) {
+      continue;
+    }
+    CatalogDay day;
+    if (indexFile(entry.path().string(), day)) {
+      days.push_back(day);
+    } else {
+      std::cout << "OrderBookCatalog skipping " << entry.path() << std::endl;
+    }
+  }
+  if (error) {
+    std::cout << "OrderBookCatalog cannot read " << directory << std::endl;
+  }
+  std::sort(days.begin(), days.end(),
+            [](const CatalogDay &d1, const CatalogDay &d2) {
+              return d1.firstTimestamp < d2.firstTimestamp;
+            });
+  std::cout << "OrderBookCatalog indexed " << days.size() << " days"
+            << std::endl;
+}
+
+bool OrderBookCatalog::isDayFile(const std::string &name) {
+  for (const char *suffix : {".csv", ".csv.gz"}) {
+    std::string extension{suffix};
+    if (name.size() > extension.size() &&
+        name.compare(name.size() - extension.size(), extension.size(),
+                     extension) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string OrderBookCatalog::lineTimestamp(const std::string &line) {
+  return line.substr(0, line.find(','));
+}
+
+// Only the first line and the tail of a plain file are read
+bool OrderBookCatalog::indexFile(const std::string &path, CatalogDay &day) {
+  std::string line;
+  {
+    BlockReader reader{path, 1 << 16};
+    if (!reader.isOpen() || !reader.getline(line) || line.empty()) {
+      return false;
+    }
+    day.path = path;
+    day.firstTimestamp = lineTimestamp(line);
+    // A compressed file has no tail to seek to, it is read through instead
+    if (reader.getFormat() != BlockReader::Format::plain) {
+      std::string last = line;
+      while (reader.getline(line)) {
+        if (!line.empty()) {
+          last = line;
+        }
+      }
+      day.lastTimestamp = lineTimestamp(last);
+      return !reader.failed();
+    }
+  }
+
+  std::ifstream file{path, std::ios::binary};
+  if (!file.is_open()) {
+    return false;
+  }
+
+  const std::streamoff tailSize = 4096;
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg();
+  std::streamoff start = size > tailSize ? size - tailSize : 0;
+  std::string tail(size - start, '\0');
+  file.seekg(start);
+  file.read(&tail[0], tail.size());
+
+  // Drop trailing line breaks, then take the last line
+  std::size_t end = tail.find_last_not_of("\r\n");
+  if (end == std::string::npos) {
+    return false;
+  }
+  std::size_t begin = tail.rfind('\n', end);
+  begin = begin == std::string::npos ? 0 : begin + 1;
+  day.lastTimestamp = lineTimestamp(tail.substr(begin, end + 1 - begin));
+  return true;
+}
+
+OrderBook &OrderBookCatalog::getDay(unsigned int index) {
+  recentlyUsed.remove(index);
+  recentlyUsed.push_front(index);
+
+  auto found = loaded.find(index);
+  if (found != loaded.end()) {
+    return *found->second;
+  }
+  std::unique_ptr<OrderBook> book{new OrderBook{days[index].path}};
+  std::size_t bytes = book->getMemoryUsage();
+  OrderBook &day = *book;
+  loaded[index] = std::move(book);
+  loadedSizes[index] = bytes;
+  loadedBytes += bytes;
+  evictFor(index);
+  return day;
+}
+
+void OrderBookCatalog::evictFor(unsigned int keep) {
+  while (loadedBytes > memoryBudget && loaded.size() > 1) {
+    unsigned int victim = recentlyUsed.back();
+    if (victim == keep) {
+      break;
+    }
+    recentlyUsed.pop_back();
+    loadedBytes -= loadedSizes[victim];
+    loadedSizes.erase(victim);
+    loaded.erase(victim);
+  }
+}
+
+int OrderBookCatalog::findDay(const std::string &timestamp) const {
+  for (unsigned int i = 0; i < days.size(); i++) {
+    if (timestamp >= days[i].firstTimestamp &&
+        timestamp <= days[i].lastTimestamp) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+std::vector<OrderBookEntry>
+OrderBookCatalog::getOrders(OrderBookType type, const std::string &product,
+                            const std::string &timestamp) {
+  int index = findDay(timestamp);
+  if (index < 0) {
+    return std::vector<OrderBookEntry>{};
+  }
+  return getDay(index).getOrders(type, product, timestamp);
+}
+
+std::string OrderBookCatalog::getEarliestTime() const {
+  return days.empty() ? "" : days.front().firstTimestamp;
+}
+
+std::string OrderBookCatalog::getNextTime(const std::string &timestamp) {
+  if (days.empty()) {
+    return "";
+  }
+  int index = findDay(timestamp);
+  if (index >= 0 && timestamp < days[index].lastTimestamp) {
+    // A day whose lines could not be loaded gives no time, or wraps to its own start
+    std::string next = getDay(index).getNextTime(timestamp);
+    if (next > timestamp) {
+      return next;
+    }
+  }
+  // Past the end of a day, or between two days: the next day that starts later
+  for (const CatalogDay &day : days) {
+    if (day.firstTimestamp > timestamp) {
+      return day.firstTimestamp;
+    }
+  }
+  return getEarliestTime();
+}
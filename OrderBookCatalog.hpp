@@ -0,0 +1,62 @@
+#pragma once
+
+#include "OrderBook.hpp"
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** one day file of the catalog and the time range it covers */
+struct CatalogDay {
+  std::string path;
+  std::string firstTimestamp;
+  std::string lastTimestamp;
+};
+
+/** a set of day files seen as one order book history.
+ * Each file's time range is indexed at construction from its first and last
+ * lines only. A day is loaded the first time it is asked for, and the least
+ * recently used days are dropped once the loaded books exceed the memory
+ * budget. An OrderBook reference stays valid until the next day is loaded.
+ */
+class OrderBookCatalog {
+public:
+  /** index every .csv file of the directory, .csv.gz ones too */
+  OrderBookCatalog(const std::string &directory,
+                   std::size_t memoryBudget = 1024 * 1024 * 1024);
+  /** indexed days, ordered by time */
+  const std::vector<CatalogDay> &getDays() const { return days; }
+  /** order book of a day, loading it if needed */
+  OrderBook &getDay(unsigned int index);
+  /** index of the day covering the timestamp, or -1 if none does */
+  int findDay(const std::string &timestamp) const;
+
+  /** return vector of Orders according to the sent filters*/
+  std::vector<OrderBookEntry> getOrders(OrderBookType type,
+                                        const std::string &product,
+                                        const std::string &timestamp);
+  /** returns the earliest time of the whole catalog */
+  std::string getEarliestTime() const;
+  /** returns the next time after the sent time, crossing into the next day
+   * when needed. Wraps around to the start after the last day */
+  std::string getNextTime(const std::string &timestamp);
+  /** approximate bytes held by the loaded days */
+  std::size_t getLoadedBytes() const { return loadedBytes; }
+  unsigned int getLoadedDayCount() const { return loaded.size(); }
+
+private:
+  static bool isDayFile(const std::string &name);
+  static bool indexFile(const std::string &path, CatalogDay &day);
+  static std::string lineTimestamp(const std::string &line);
+  void evictFor(unsigned int keep);
+
+  std::vector<CatalogDay> days;
+  std::size_t memoryBudget;
+  std::size_t loadedBytes;
+  std::map<unsigned int, std::unique_ptr<OrderBook>> loaded;
+  std::map<unsigned int, std::size_t> loadedSizes;
+  // Most recently used day first
+  std::list<unsigned int> recentlyUsed;
+};
@@ -1,14 +1,14 @@
 #include "OrderBookEntry.hpp"
+#include <utility>
 
 OrderBookEntry::OrderBookEntry(double _price, double _amount,
                                std::string _timestamp, std::string _product,
-                               OrderBookType _orderType, std::string _username,
-                               std::string _controlString)
-    : price(_price), amount(_amount), timestamp(_timestamp), product(_product),
-      orderType(_orderType), username(_username),
-      controlString(_controlString) {}
+                               OrderBookType _orderType, AccountId _accountId)
+    : price(_price), amount(_amount), timestamp(std::move(_timestamp)),
+      product(std::move(_product)), orderType(_orderType),
+      accountId(_accountId) {}
 
-OrderBookType OrderBookEntry::stringToOrderBookType(std::string s) {
+OrderBookType OrderBookEntry::stringToOrderBookType(const std::string &s) {
   if (s == "ask") {
     return OrderBookType::ask;
   }
@@ -17,3 +17,15 @@ OrderBookType OrderBookEntry::stringToOrderBookType(std::string s) {
   }
   return OrderBookType::unknown;
 }
+
+std::string SaleContext::toString() const {
+  return "max ask: " + std::to_string(maxAsk) +
+         " | min ask: " + std::to_string(minAsk) +
+         " | max bid: " + std::to_string(maxBid) +
+         " | min bid: " + std::to_string(minBid);
+}
+
+std::ostream &operator<<(std::ostream &os, const SaleContext &context) {
+  os << context.toString();
+  return os;
+}
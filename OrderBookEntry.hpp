@@ -1,17 +1,40 @@
 #pragma once
 
+#include <cstdint>
+#include <ostream>
 #include <string>
 
 enum class OrderBookType { bid, ask, unknown, asksale, bidsale };
 
+/** integer owner of an order, see AccountLedger.hpp */
+using AccountId = std::uint32_t;
+/** the orders read from the data belong to the market itself */
+constexpr AccountId datasetAccount = 0;
+/** the user of the interactive menu */
+constexpr AccountId simuserAccount = 1;
+/** MerkelBot */
+constexpr AccountId botAccount = 2;
+
+/** market context a sale was matched in, only formatted when it is logged */
+struct SaleContext {
+  double maxAsk = 0;
+  double minAsk = 0;
+  double maxBid = 0;
+  double minBid = 0;
+
+  /** generate a string representation of the context */
+  std::string toString() const;
+};
+
+std::ostream &operator<<(std::ostream &os, const SaleContext &context);
+
 class OrderBookEntry {
 public:
   OrderBookEntry(double _price, double _amount, std::string _timestamp,
                  std::string _product, OrderBookType _orderType,
-                 std::string username = "dataset",
-                 std::string controlString = "");
+                 AccountId _accountId = datasetAccount);
 
-  static OrderBookType stringToOrderBookType(std::string s);
+  static OrderBookType stringToOrderBookType(const std::string &s);
 
   static bool compareByTimestamp(OrderBookEntry &e1, OrderBookEntry &e2) {
     return e1.timestamp < e2.timestamp;
@@ -28,6 +51,9 @@ public:
   std::string timestamp;
   std::string product;
   OrderBookType orderType;
-  std::string username;
-  std::string controlString;
+  /** owner of the order, or of the sale for a bidsale or asksale */
+  AccountId accountId;
+  /** account on the other side of a sale */
+  AccountId counterpartyId = datasetAccount;
+  SaleContext context;
 };
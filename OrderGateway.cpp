@@ -0,0 +1,65 @@
+#include "OrderGateway.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+OrderGateway::OrderGateway(const std::string &_exchangePath)
+    : socketFd(::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0)),
+      exchangePath(_exchangePath), sequence(0), sentCount(0) {}
+
+OrderGateway::~OrderGateway() {
+  if (socketFd >= 0)
+    ::close(socketFd);
+}
+
+bool OrderGateway::sendMessage(const FeedMessage &message) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketFd < 0 || exchangePath.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::strcpy(address.sun_path, exchangePath.c_str());
+  return ::sendto(socketFd, &message, sizeof(message), 0,
+                  reinterpret_cast<sockaddr *>(&address),
+                  sizeof(address)) == sizeof(message);
+}
+
+bool OrderGateway::send(const OrderBookEntry &order) {
+  FeedMessage message{};
+  auto product = productIds.find(order.product);
+  if (product == productIds.end()) {
+    std::uint16_t id = productIds.size();
+    message.type = FeedMessageType::product;
+    message.productId = id;
+    // The symbol field is only NUL terminated when shorter than the field
+    std::memcpy(message.body.symbol, order.product.data(),
+                std::min(order.product.size(), sizeof(message.body.symbol)));
+    message.sequence = sequence++;
+    message.sendTime = feedClockNanos();
+    if (!sendMessage(message)) {
+      return false;
+    }
+    product = productIds.emplace(order.product, id).first;
+  }
+
+  message = FeedMessage{};
+  message.type = FeedMessageType::newOrder;
+  message.side = static_cast<std::uint8_t>(order.orderType);
+  message.productId = product->second;
+  message.sequence = sequence++;
+  try {
+    message.timestamp = Timestamp::toMicros(order.timestamp);
+  } catch (const std::exception &e) {
+    return false;
+  }
+  message.body.order = FeedOrder{order.price, order.amount};
+  message.sendTime = feedClockNanos();
+  if (!sendMessage(message)) {
+    return false;
+  }
+  sentCount++;
+  return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "FeedProtocol.hpp"
+#include "OrderBookEntry.hpp"
+#include <map>
+#include <string>
+
+/** sends the bot's orders to the mock exchange over a Unix datagram socket,
+ * in the feed's binary format. Each order is one datagram, sent without
+ * waiting for an answer. */
+class OrderGateway {
+public:
+  /** path of the exchange's order socket */
+  OrderGateway(const std::string &exchangePath);
+  ~OrderGateway();
+  OrderGateway(const OrderGateway &) = delete;
+  OrderGateway &operator=(const OrderGateway &) = delete;
+
+  /** send an order, returns false if the exchange could not take it */
+  bool send(const OrderBookEntry &order);
+  unsigned int getSentCount() const { return sentCount; }
+
+private:
+  bool sendMessage(const FeedMessage &message);
+
+  int socketFd;
+  std::string exchangePath;
+  // Products are announced to the exchange the first time they are traded
+  std::map<std::string, std::uint16_t> productIds;
+  std::uint32_t sequence;
+  unsigned int sentCount;
+};
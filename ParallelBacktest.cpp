@@ -0,0 +1,92 @@
+#include "ParallelBacktest.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+ParallelBacktest::ParallelBacktest(unsigned int _segmentCount,
+                                   unsigned int _warmupTimestamps)
+    : segmentCount(_segmentCount), warmupTimestamps(_warmupTimestamps) {}
+
+// The commits of the segments are applied in timeline order to the one
+// wallet, each as the transaction it was in the segment, so a commit is only
+// applied if the balances left by all the earlier ones cover it
+void ParallelBacktest::stitch(Wallet &wallet, const std::string &logFile) {
+  for (BacktestSegment &segment : segments) {
+    segment.rejectedCommits = 0;
+    for (const std::vector<OrderBookEntry> &sales : segment.commits) {
+      WalletTransaction transaction;
+      for (const OrderBookEntry &sale : sales) {
+        transaction.addSale(sale);
+      }
+      if (!wallet.commit(transaction)) {
+        segment.rejectedCommits++;
+      }
+    }
+  }
+  stitchedBalances = wallet.getBalances();
+
+  // The segment logs are appended to the run's log in timeline order
+  std::ofstream log{logFile};
+  for (unsigned int k = 0; k < segments.size(); k++) {
+    const BacktestSegment &segment = segments[k];
+    log << "Segment " << k << " | trading from " << segment.tradeFrom
+        << " after " << segment.warmupTimestamps << " warm-up timestamps"
+        << std::endl;
+    std::ifstream part{segment.logFile};
+    log << part.rdbuf();
+    part.close();
+    std::remove(segment.logFile.c_str());
+  }
+}
+
+double
+ParallelBacktest::secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void ParallelBacktest::printReport(std::ostream &os) const {
+  os << "Parallel backtest: " << segments.size() << " segments, "
+     << warmupTimestamps << " warm-up timestamps, " << seconds << " s"
+     << std::endl;
+  unsigned int orders = 0;
+  for (unsigned int k = 0; k < segments.size(); k++) {
+    const BacktestSegment &segment = segments[k];
+    os << "  segment " << k << " from " << segment.tradeFrom << " to "
+       << (segment.tradeTo.empty() ? "end" : segment.tradeTo) << ": "
+       << segment.ordersPlaced << " orders, " << segment.commits.size()
+       << " wallet commits, " << segment.rejectedCommits
+       << " rejected when stitched, " << segment.seconds << " s" << std::endl;
+    orders += segment.ordersPlaced;
+  }
+  if (!verified) {
+    return;
+  }
+
+  os << "Sequential run: " << sequentialOrders << " orders, "
+     << sequentialSeconds << " s, speedup "
+     << (seconds > 0 ? sequentialSeconds / seconds : 0) << "x" << std::endl;
+  os << "Stitching error" << std::endl;
+  os << "  orders: " << orders << " stitched, " << sequentialOrders
+     << " sequential" << std::endl;
+  std::streamsize precision = os.precision();
+  std::map<std::string, double> currencies = sequentialBalances;
+  currencies.insert(stitchedBalances.begin(), stitchedBalances.end());
+  for (auto const &c : currencies) {
+    auto s = stitchedBalances.find(c.first);
+    auto q = sequentialBalances.find(c.first);
+    double stitchedAmount = s == stitchedBalances.end() ? 0 : s->second;
+    double sequentialAmount = q == sequentialBalances.end() ? 0 : q->second;
+    double error = std::fabs(stitchedAmount - sequentialAmount);
+    os << "  " << c.first << ": " << std::fixed << std::setprecision(6)
+       << stitchedAmount << " stitched, " << sequentialAmount
+       << " sequential, error " << error;
+    if (sequentialAmount != 0) {
+      os << " (" << std::setprecision(4)
+         << 100 * error / std::fabs(sequentialAmount) << "%)";
+    }
+    os << std::defaultfloat << std::setprecision(precision) << std::endl;
+  }
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "Instrumentation.hpp"
+#include "MerkelBot.hpp"
+#include "OrderBook.hpp"
+#include "ProductConfig.hpp"
+#include "TradingStrategy.hpp"
+#include "Wallet.hpp"
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** one slice of the timeline of a parallel backtest */
+struct BacktestSegment {
+  /** the segment trades on the timestamps in [tradeFrom, tradeTo), up to the
+   * end of the book if tradeTo is empty */
+  std::string tradeFrom;
+  std::string tradeTo;
+  /** first timestamp the strategy sees, warmupTimestamps before tradeFrom */
+  std::string warmupFrom;
+  unsigned int warmupTimestamps = 0;
+  /** snapshot cadence of a sequential replay when it reaches warmupFrom */
+  int timestampCounter = 0;
+  double snapshotCounter = 0;
+  std::string previousTimestamp;
+
+  std::string logFile;
+  unsigned int ordersPlaced = 0;
+  /** sales of every wallet commit the segment made once trading, in order */
+  std::vector<std::vector<OrderBookEntry>> commits;
+  /** commits the stitched wallet could not cover */
+  unsigned int rejectedCommits = 0;
+  double seconds = 0;
+};
+
+/** replays one product's history as segments of the timeline, each on its
+ * own thread with its own copy of the starting wallet. The segments share
+ * the book, which the bot only reads.
+ * A segment starts its strategy warmupTimestamps before the first timestamp
+ * it trades on, with the snapshot cadence a sequential replay would have
+ * there, and only trades once the warm-up is over. The segments are then
+ * stitched: the sales of their wallet commits are replayed in timeline
+ * order through one running wallet, which rejects any commit it cannot
+ * cover. Stitching is exact for strategies whose state only depends on a
+ * bounded window of the past. EMA and VWAP depend on all of it and a
+ * segment decides on its own balances, so verify measures the error
+ * against a sequential run. */
+class ParallelBacktest {
+public:
+  ParallelBacktest(unsigned int _segmentCount,
+                   unsigned int _warmupTimestamps);
+  /** run the segments and stitch their wallet commits into the wallet and
+   * their logs into logFile. The book itself is left untouched */
+  template <typename Strategy>
+  void run(OrderBook &orderBook, Wallet &wallet, const ProductConfig &config,
+           const std::string &logFile);
+  /** replay the same history sequentially from the starting wallet, on the
+   * book itself, and keep the result to compare the stitched one with */
+  template <typename Strategy>
+  void verify(OrderBook &orderBook, const Wallet &initialWallet,
+              const ProductConfig &config, const std::string &logFile);
+  /** per-segment timings and orders, and the stitching error once verified */
+  void printReport(std::ostream &os) const;
+
+  const std::vector<BacktestSegment> &getSegments() const { return segments; }
+
+private:
+  template <typename Strategy>
+  void plan(OrderBook &orderBook, const ProductConfig &config,
+            const std::string &logFile);
+  template <typename Strategy>
+  static void runSegment(OrderBook &orderBook, const Wallet &initialWallet,
+                         const ProductConfig &config,
+                         BacktestSegment &segment);
+  void stitch(Wallet &wallet, const std::string &logFile);
+  static double secondsSince(std::chrono::steady_clock::time_point start);
+
+  unsigned int segmentCount;
+  unsigned int warmupTimestamps;
+  std::vector<BacktestSegment> segments;
+  double seconds = 0;
+  std::map<std::string, double> stitchedBalances;
+
+  bool verified = false;
+  std::map<std::string, double> sequentialBalances;
+  unsigned int sequentialOrders = 0;
+  double sequentialSeconds = 0;
+};
+
+template <typename Strategy>
+void ParallelBacktest::run(OrderBook &orderBook, Wallet &wallet,
+                           const ProductConfig &config,
+                           const std::string &logFile) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  plan<Strategy>(orderBook, config, logFile);
+  // Every segment starts from the same wallet, its commits are replayed afterwards
+  const Wallet initialWallet = wallet;
+  std::vector<std::thread> workers;
+  for (BacktestSegment &segment : segments) {
+    workers.emplace_back([&orderBook, &initialWallet, &config, &segment]() {
+      runSegment<Strategy>(orderBook, initialWallet, config, segment);
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  // The stage latencies of every segment, once they are all done
+  MERKEL_DUMP_STATS(std::cout);
+  stitch(wallet, logFile);
+  seconds = secondsSince(start);
+}
+
+template <typename Strategy>
+void ParallelBacktest::verify(OrderBook &orderBook,
+                              const Wallet &initialWallet,
+                              const ProductConfig &config,
+                              const std::string &logFile) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  Wallet wallet = initialWallet;
+  Strategy strategy;
+  MerkelBot bot;
+  bot.setLogFile(logFile);
+  bot.run(orderBook, wallet, config, strategy);
+  sequentialSeconds = secondsSince(start);
+  sequentialOrders = bot.getOrdersPlaced();
+  sequentialBalances = wallet.getBalances();
+  verified = true;
+}
+
+// The segments split the distinct timestamps of the product's bids evenly.
+// The cadence at each warm-up start is found by running the counters alone
+// over the timestamps before it, which is cheap next to a replay.
+template <typename Strategy>
+void ParallelBacktest::plan(OrderBook &orderBook, const ProductConfig &config,
+                            const std::string &logFile) {
+  std::vector<std::string> timestamps =
+      orderBook.getBidTimestamps(config.product);
+  unsigned int count = segmentCount;
+  if (count > timestamps.size()) {
+    count = timestamps.size();
+  }
+  if (count == 0) {
+    count = 1;
+  }
+
+  segments.assign(count, BacktestSegment{});
+  int timestampCounter = 0;
+  double snapshotCounter = 0;
+  unsigned int position = 0;
+  for (unsigned int k = 0; k < count; k++) {
+    BacktestSegment &segment = segments[k];
+    unsigned int first = timestamps.size() * k / count;
+    unsigned int end = timestamps.size() * (k + 1) / count;
+    unsigned int warmupFirst =
+        first > warmupTimestamps ? first - warmupTimestamps : 0;
+    while (position < warmupFirst) {
+      TradingStrategy<Strategy>::advanceCadence(timestampCounter,
+                                                snapshotCounter);
+      position++;
+    }
+    segment.tradeFrom = first < timestamps.size() ? timestamps[first] : "";
+    segment.tradeTo = end < timestamps.size() ? timestamps[end] : "";
+    segment.warmupFrom =
+        warmupFirst < timestamps.size() ? timestamps[warmupFirst] : "";
+    segment.warmupTimestamps = first - warmupFirst;
+    segment.timestampCounter = timestampCounter;
+    segment.snapshotCounter = snapshotCounter;
+    segment.previousTimestamp =
+        warmupFirst > 0 ? timestamps[warmupFirst - 1] : "";
+    segment.logFile = logFile + ".segment" + std::to_string(k);
+  }
+}
+
+template <typename Strategy>
+void ParallelBacktest::runSegment(OrderBook &orderBook,
+                                  const Wallet &initialWallet,
+                                  const ProductConfig &config,
+                                  BacktestSegment &segment) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  // The bot matches its orders without inserting them, so the segments
+  // share the book and each replays its own range of it
+  Wallet wallet = initialWallet;
+  Strategy strategy;
+  strategy.prime(segment.timestampCounter, segment.snapshotCounter,
+                 segment.previousTimestamp);
+  MerkelBot bot;
+  bot.setLogFile(segment.logFile);
+  bot.setReplayRange(segment.warmupFrom, segment.tradeTo);
+  bot.setTradingStart(segment.tradeFrom);
+  bot.setCommitLog(&segment.commits);
+  bot.setConsoleOutput(false);
+  bot.run(orderBook, wallet, config, strategy);
+  segment.ordersPlaced = bot.getOrdersPlaced();
+  segment.seconds = secondsSince(start);
+}
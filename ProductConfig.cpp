@@ -0,0 +1,28 @@
+#include "ProductConfig.hpp"
+
+// Every product's parameters come from its entry in productSpecs
+ProductConfig ProductConfig::forId(ProductId id) {
+  ProductConfig config;
+  if (!isKnownProduct(id)) {
+    return config;
+  }
+  const ProductSpec &spec = productSpec(id);
+  config.id = id;
+  config.product = spec.symbol;
+  config.baseCurrency = spec.baseCurrency;
+  config.quoteCurrency = spec.quoteCurrency;
+  config.dealSize = spec.dealSize;
+  config.bidDelta = spec.bidDelta;
+  config.askDelta = spec.askDelta;
+  config.priceScale = spec.priceScale;
+  return config;
+}
+
+// User input 1 corresponds to the first product of the registry, BTC/USDT
+ProductConfig ProductConfig::forMenuOption(int option) {
+  return forId(productForMenuOption(option));
+}
+
+ProductConfig ProductConfig::forProduct(const std::string &product) {
+  return forId(productForSymbol(product));
+}
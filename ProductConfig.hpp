@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ProductRegistry.hpp"
+#include <string>
+
+/** per-product trading parameters, resolved once when the bot is set up.
+ * A copy of the product's ProductSpec, with the names as strings for the
+ * order book and the wallet */
+struct ProductConfig {
+  ProductId id = ProductId::unknown;
+  std::string product;
+  std::string baseCurrency;
+  std::string quoteCurrency;
+  /** amount of the base currency bought or sold by each order */
+  double dealSize = 0;
+  /** EMA delta above which the bot buys */
+  double bidDelta = 0;
+  /** EMA delta below which the bot sells */
+  double askDelta = 0;
+  /** smallest price step of the product */
+  double priceScale = 0;
+
+  /** config of a product of the registry, empty for an unknown id */
+  static ProductConfig forId(ProductId id);
+  /** config of the product behind a bot submenu option (1 for the first) */
+  static ProductConfig forMenuOption(int option);
+  /** config of a product given by name, e.g. "ETH/BTC" */
+  static ProductConfig forProduct(const std::string &product);
+  /** true if the product is one the bot knows how to trade */
+  bool isValid() const { return isKnownProduct(id); }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/** index of a product in productSpecs */
+enum class ProductId : std::uint8_t { unknown = 0xff };
+
+/** everything the bot needs to know to trade a product */
+struct ProductSpec {
+  const char *symbol;
+  const char *baseCurrency;
+  const char *quoteCurrency;
+  /** amount of the base currency bought or sold by each order */
+  double dealSize;
+  /** EMA delta above which the bot buys */
+  double bidDelta;
+  /** EMA delta below which the bot sells */
+  double askDelta;
+  /** smallest price step of the product, in the quote currency */
+  double priceScale;
+};
+
+/** the products the bot trades, in bot submenu order. Adding a product only
+ * takes a line here: its id, menu option and lookups all follow from it.
+ * Each product has a deal size based on its value, and its own EMA delta
+ * thresholds for triggering any bot action */
+constexpr ProductSpec productSpecs[] = {
+    {"BTC/USDT", "BTC", "USDT", 1, 0.2, -0.2, 0.01},
+    {"ETH/BTC", "ETH", "BTC", 10, 8.44151e-06, -5.0012e-06, 1e-8},
+    {"DOGE/BTC", "DOGE", "BTC", 100, 0.001, -0.001, 1e-8},
+};
+
+constexpr std::size_t productCount =
+    sizeof(productSpecs) / sizeof(productSpecs[0]);
+static_assert(productCount < static_cast<std::size_t>(ProductId::unknown),
+              "ProductId::unknown must not be a table index");
+
+/** spec of a known product, a plain table lookup */
+constexpr const ProductSpec &productSpec(ProductId id) {
+  return productSpecs[static_cast<std::size_t>(id)];
+}
+
+/** true for the id of a product in the table */
+constexpr bool isKnownProduct(ProductId id) {
+  return static_cast<std::size_t>(id) < productCount;
+}
+
+/** product behind a bot submenu option, 1 for the first product */
+constexpr ProductId productForMenuOption(int option) {
+  return option >= 1 && static_cast<std::size_t>(option) <= productCount
+             ? static_cast<ProductId>(option - 1)
+             : ProductId::unknown;
+}
+
+/** product with this symbol, e.g. "ETH/BTC". Meant for setup time, the hot
+ * path passes ids around */
+constexpr ProductId productForSymbol(std::string_view symbol) {
+  for (std::size_t i = 0; i < productCount; i++) {
+    if (symbol == productSpecs[i].symbol) {
+      return static_cast<ProductId>(i);
+    }
+  }
+  return ProductId::unknown;
+}
+
+static_assert(productForSymbol(productSpecs[productCount - 1].symbol) ==
+                  static_cast<ProductId>(productCount - 1),
+              "product lookups resolve at compile time");
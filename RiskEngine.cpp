@@ -0,0 +1,151 @@
+#include "RiskEngine.hpp"
+#include <algorithm>
+#include <cmath>
+
+RiskEngine::RiskEngine() {}
+
+void RiskEngine::setLimits(ProductId product, const RiskLimits &limits) {
+  ProductRisk &risk = state[index(product)];
+  risk.limits = limits;
+  // Times far enough in the past never count against the window
+  risk.sendTimes.assign(limits.maxOrders,
+                        std::numeric_limits<std::int64_t>::min() / 2);
+  risk.next = 0;
+}
+
+// Cheapest and most common rejections first
+RiskResult RiskEngine::check(ProductId product, OrderBookType side,
+                             double price, double amount,
+                             std::int64_t micros) {
+  RiskResult result = RiskResult::accepted;
+  if (!isKnownProduct(product)) {
+    result = RiskResult::unknownProduct;
+  } else {
+    const ProductRisk &risk = state[index(product)];
+    const bool buying = side == OrderBookType::bid;
+    // The position if every open order on this side fills, without and with
+    // the new order
+    double before =
+        risk.position + (buying ? risk.openBuys : -risk.openSells);
+    double after = before + (buying ? amount : -amount);
+    const bool reducing = std::fabs(after) <= std::fabs(before);
+    if (risk.limits.priceBand > 0 &&
+        std::fabs(price - risk.referencePrice) >
+            risk.limits.priceBand * risk.referencePrice) {
+      result = RiskResult::priceBand;
+    } else if (!reducing && std::fabs(after) > risk.limits.maxPosition) {
+      result = RiskResult::position;
+    } else if (!reducing &&
+               std::fabs(after) * price > risk.limits.maxNotional) {
+      result = RiskResult::notional;
+    } else if (risk.limits.maxOrders > 0 &&
+               micros - risk.sendTimes[risk.next] <
+                   risk.limits.windowMicros) {
+      // The ring is full of orders sent within the window
+      result = RiskResult::rate;
+    }
+  }
+  results[static_cast<std::size_t>(result)]++;
+  return result;
+}
+
+void RiskEngine::onOrderSent(ProductId product, OrderBookType side,
+                             double amount, std::int64_t micros) {
+  ProductRisk &risk = state[index(product)];
+  (side == OrderBookType::bid ? risk.openBuys : risk.openSells) += amount;
+  if (risk.limits.maxOrders == 0) {
+    return;
+  }
+  risk.sendTimes[risk.next] = micros;
+  risk.next = risk.next + 1 == risk.sendTimes.size() ? 0 : risk.next + 1;
+}
+
+void RiskEngine::onFill(ProductId product, OrderBookType saleType,
+                        double amount) {
+  ProductRisk &risk = state[index(product)];
+  // What fills is no longer open
+  if (saleType == OrderBookType::bidsale) {
+    risk.position += amount;
+    risk.openBuys = std::max(0.0, risk.openBuys - amount);
+  } else if (saleType == OrderBookType::asksale) {
+    risk.position -= amount;
+    risk.openSells = std::max(0.0, risk.openSells - amount);
+  }
+}
+
+void RiskEngine::onOrderClosed(ProductId product, OrderBookType side,
+                               double unfilled) {
+  ProductRisk &risk = state[index(product)];
+  double &open = side == OrderBookType::bid ? risk.openBuys : risk.openSells;
+  open = std::max(0.0, open - unfilled);
+}
+
+void RiskEngine::save(CheckpointWriter &out) const {
+  for (const ProductRisk &risk : state) {
+    out.write(risk.position);
+    // Oldest send time first, so a ring of another size can take them back
+    out.write(static_cast<std::uint32_t>(risk.sendTimes.size()));
+    for (std::size_t i = 0; i < risk.sendTimes.size(); i++) {
+      out.write(risk.sendTimes[(risk.next + i) % risk.sendTimes.size()]);
+    }
+  }
+  for (std::uint64_t count : results) {
+    out.write(count);
+  }
+}
+
+void RiskEngine::load(CheckpointReader &in) {
+  for (ProductRisk &risk : state) {
+    in.read(risk.position);
+    risk.openBuys = 0;
+    risk.openSells = 0;
+    std::uint32_t count;
+    in.read(count);
+    std::vector<std::int64_t> times(count);
+    for (std::int64_t &time : times) {
+      in.read(time);
+    }
+    // The ring keeps the newest times that fit the current maxOrders
+    std::fill(risk.sendTimes.begin(), risk.sendTimes.end(),
+              std::numeric_limits<std::int64_t>::min() / 2);
+    risk.next = 0;
+    std::size_t skip = times.size() > risk.sendTimes.size()
+                           ? times.size() - risk.sendTimes.size()
+                           : 0;
+    for (std::size_t i = skip; i < times.size(); i++) {
+      risk.sendTimes[risk.next] = times[i];
+      risk.next = risk.next + 1 == risk.sendTimes.size() ? 0 : risk.next + 1;
+    }
+  }
+  for (std::uint64_t &count : results) {
+    in.read(count);
+  }
+}
+
+const char *RiskEngine::resultName(RiskResult result) {
+  switch (result) {
+  case RiskResult::accepted:
+    return "accepted";
+  case RiskResult::position:
+    return "position limit";
+  case RiskResult::notional:
+    return "notional limit";
+  case RiskResult::rate:
+    return "order rate limit";
+  case RiskResult::priceBand:
+    return "price band";
+  case RiskResult::unknownProduct:
+    return "unknown product";
+  default:
+    return "unknown";
+  }
+}
+
+void RiskEngine::printReport(std::ostream &os) const {
+  os << "Risk checks:";
+  for (std::size_t i = 0; i < results.size(); i++) {
+    os << (i == 0 ? " " : ", ") << resultName(static_cast<RiskResult>(i))
+       << " " << results[i];
+  }
+  os << std::endl;
+}
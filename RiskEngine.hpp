@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Checkpoint.hpp"
+#include "OrderBookEntry.hpp"
+#include "ProductRegistry.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+/** pre-trade limits of one product. Every limit is off by default */
+struct RiskLimits {
+  /** largest net position in the base currency, long or short */
+  double maxPosition = std::numeric_limits<double>::infinity();
+  /** largest value of the net position in the quote currency */
+  double maxNotional = std::numeric_limits<double>::infinity();
+  /** most orders sent within any window of windowMicros, 0 for no limit */
+  unsigned int maxOrders = 0;
+  std::int64_t windowMicros = 1000000;
+  /** largest distance of an order's price from the reference price, as a
+   * fraction of it. 0 for no band */
+  double priceBand = 0;
+};
+
+/** why an order was let through or stopped */
+enum class RiskResult : std::uint8_t {
+  accepted,
+  position,
+  notional,
+  rate,
+  priceBand,
+  unknownProduct,
+  count
+};
+
+/** checks orders against the limits of their product before they go out.
+ * Everything a check needs is kept up to date as orders are sent, filled
+ * and closed: the net position, the amounts of the orders still open on
+ * each side, the reference price, and the send times of the last maxOrders
+ * orders in a ring, so a check is a handful of comparisons with no
+ * allocation and no search. The position and notional limits assume every
+ * open order on the order's side fills, and never stop an order that
+ * brings that position closer to flat */
+class RiskEngine {
+public:
+  RiskEngine();
+
+  void setLimits(ProductId product, const RiskLimits &limits);
+  /** price the band is centred on, usually the latest snapshot's */
+  void setReferencePrice(ProductId product, double price) {
+    state[index(product)].referencePrice = price;
+  }
+
+  /** check an order sent at `micros`, without recording it */
+  RiskResult check(ProductId product, OrderBookType side, double price,
+                   double amount, std::int64_t micros);
+  /** record an order that passed its check and was sent, open until it is
+   * filled or closed */
+  void onOrderSent(ProductId product, OrderBookType side, double amount,
+                   std::int64_t micros);
+  /** record a bidsale or asksale of the account the engine guards */
+  void onFill(ProductId product, OrderBookType saleType, double amount);
+  /** an order was cancelled, expired or matched for the last time with
+   * `unfilled` of it left, which is no longer open */
+  void onOrderClosed(ProductId product, OrderBookType side, double unfilled);
+
+  double getPosition(ProductId product) const {
+    return state[index(product)].position;
+  }
+  /** amount of the open orders on one side */
+  double getOpenAmount(ProductId product, OrderBookType side) const {
+    const ProductRisk &risk = state[index(product)];
+    return side == OrderBookType::bid ? risk.openBuys : risk.openSells;
+  }
+  /** positions, order rings and counts of every product, the limits are
+   * left to the command line. Open orders are not saved, so loading clears
+   * them */
+  void save(CheckpointWriter &out) const;
+  void load(CheckpointReader &in);
+  /** checks and rejections per reason so far */
+  void printReport(std::ostream &os) const;
+  static const char *resultName(RiskResult result);
+
+private:
+  struct ProductRisk {
+    RiskLimits limits;
+    double position = 0;
+    double openBuys = 0;
+    double openSells = 0;
+    double referencePrice = 0;
+    // Send times of the last limits.maxOrders orders, the oldest at next
+    std::vector<std::int64_t> sendTimes;
+    std::size_t next = 0;
+  };
+
+  static std::size_t index(ProductId product) {
+    return static_cast<std::size_t>(product);
+  }
+
+  std::array<ProductRisk, productCount> state;
+  std::array<std::uint64_t, static_cast<std::size_t>(RiskResult::count)>
+      results{};
+};
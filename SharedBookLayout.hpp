@@ -0,0 +1,50 @@
+#pragma once
+
+#include "BookSnapshot.hpp"
+#include <atomic>
+#include <cstdint>
+
+/** layout of the POSIX shared-memory segment the bot publishes its
+ * per-product top-of-book and depth into. Each product owns one slot guarded
+ * by a seqlock: the writer makes the sequence odd while it writes, and a
+ * reader retries until it copied the slot between two equal even sequences.
+ */
+const std::uint32_t sharedBookMagic = 0x4d4b4244;
+const std::uint32_t sharedBookVersion = 1;
+const unsigned int sharedBookMaxProducts = 32;
+
+struct SharedBookLevel {
+  double price;
+  double amount;
+};
+
+/** plain copy of one product's book, as handed to readers */
+struct SharedBookSnapshot {
+  char product[16];
+  char timestamp[32];
+  double maxAsk;
+  double minAsk;
+  double maxBid;
+  double minBid;
+  std::uint32_t askCount;
+  std::uint32_t bidCount;
+  std::uint32_t askLevels;
+  std::uint32_t bidLevels;
+  SharedBookLevel asks[BookSnapshot::depthLevels];
+  SharedBookLevel bids[BookSnapshot::depthLevels];
+  /** how many times the writer published this product */
+  std::uint64_t updates;
+};
+
+struct alignas(64) SharedBookSlot {
+  std::atomic<std::uint64_t> sequence;
+  SharedBookSnapshot snapshot;
+};
+
+struct SharedBookSegment {
+  std::uint32_t magic;
+  std::uint32_t version;
+  /** slots in use, a slot's product name is written before it is counted */
+  std::atomic<std::uint32_t> productCount;
+  SharedBookSlot slots[sharedBookMaxProducts];
+};
@@ -0,0 +1,90 @@
+#include "SharedBookPublisher.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedBookPublisher::SharedBookPublisher(const std::string &_name)
+    : name(_name), segment(nullptr) {
+  int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0 || ::ftruncate(fd, sizeof(SharedBookSegment)) < 0) {
+    std::cout << "SharedBookPublisher cannot create " << name << std::endl;
+    if (fd >= 0)
+      ::close(fd);
+    return;
+  }
+  void *memory = ::mmap(nullptr, sizeof(SharedBookSegment),
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    std::cout << "SharedBookPublisher cannot map " << name << std::endl;
+    return;
+  }
+  // A fresh segment every run: readers see the magic once it is initialised
+  std::memset(memory, 0, sizeof(SharedBookSegment));
+  segment = new (memory) SharedBookSegment;
+  segment->version = sharedBookVersion;
+  segment->productCount.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  segment->magic = sharedBookMagic;
+}
+
+SharedBookPublisher::~SharedBookPublisher() {
+  if (segment != nullptr) {
+    ::munmap(segment, sizeof(SharedBookSegment));
+  }
+}
+
+bool SharedBookPublisher::publish(const std::string &product,
+                                  const std::string &timestamp,
+                                  const BookSnapshot &snapshot) {
+  if (segment == nullptr) {
+    return false;
+  }
+  auto found = slotIndexes.find(product);
+  if (found == slotIndexes.end()) {
+    unsigned int index = slotIndexes.size();
+    if (index >= sharedBookMaxProducts) {
+      return false;
+    }
+    SharedBookSnapshot &claimed = segment->slots[index].snapshot;
+    std::memcpy(claimed.product, product.data(),
+                std::min(product.size(), sizeof(claimed.product) - 1));
+    segment->productCount.store(index + 1, std::memory_order_release);
+    found = slotIndexes.emplace(product, index).first;
+  }
+
+  SharedBookSlot &slot = segment->slots[found->second];
+  std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  // Odd sequence: readers know a write is in progress and retry
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  SharedBookSnapshot &out = slot.snapshot;
+  std::memset(out.timestamp, 0, sizeof(out.timestamp));
+  std::memcpy(out.timestamp, timestamp.data(),
+              std::min(timestamp.size(), sizeof(out.timestamp) - 1));
+  out.maxAsk = snapshot.maxAsk;
+  out.minAsk = snapshot.minAsk;
+  out.maxBid = snapshot.maxBid;
+  out.minBid = snapshot.minBid;
+  out.askCount = snapshot.askCount;
+  out.bidCount = snapshot.bidCount;
+  out.askLevels = snapshot.askDepth.size();
+  out.bidLevels = snapshot.bidDepth.size();
+  for (unsigned int i = 0; i < out.askLevels; i++) {
+    out.asks[i] = SharedBookLevel{snapshot.askDepth[i].price,
+                                  snapshot.askDepth[i].amount};
+  }
+  for (unsigned int i = 0; i < out.bidLevels; i++) {
+    out.bids[i] = SharedBookLevel{snapshot.bidDepth[i].price,
+                                  snapshot.bidDepth[i].amount};
+  }
+  out.updates++;
+
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
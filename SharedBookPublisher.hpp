@@ -0,0 +1,27 @@
+#pragma once
+
+#include "BookSnapshot.hpp"
+#include "SharedBookLayout.hpp"
+#include <map>
+#include <string>
+
+/** the writing side of the shared-memory book, owned by the bot process.
+ * There must be a single writer per segment. */
+class SharedBookPublisher {
+public:
+  /** create (or take over) the segment, name as for shm_open e.g. "/merkelbook" */
+  SharedBookPublisher(const std::string &name);
+  ~SharedBookPublisher();
+  SharedBookPublisher(const SharedBookPublisher &) = delete;
+  SharedBookPublisher &operator=(const SharedBookPublisher &) = delete;
+
+  bool isOpen() const { return segment != nullptr; }
+  /** publish a product's snapshot, returns false when out of slots */
+  bool publish(const std::string &product, const std::string &timestamp,
+               const BookSnapshot &snapshot);
+
+private:
+  std::string name;
+  SharedBookSegment *segment;
+  std::map<std::string, unsigned int> slotIndexes;
+};
@@ -0,0 +1,75 @@
+#include "SharedBookReader.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedBookReader::SharedBookReader(const std::string &name)
+    : segment(nullptr), retries(0), failedReads(0) {
+  int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return;
+  }
+  void *memory =
+      ::mmap(nullptr, sizeof(SharedBookSegment), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory != MAP_FAILED) {
+    segment = static_cast<const SharedBookSegment *>(memory);
+  }
+}
+
+SharedBookReader::~SharedBookReader() {
+  if (segment != nullptr) {
+    ::munmap(const_cast<SharedBookSegment *>(segment),
+             sizeof(SharedBookSegment));
+  }
+}
+
+bool SharedBookReader::isOpen() const {
+  if (segment == nullptr) {
+    return false;
+  }
+  bool ready = segment->magic == sharedBookMagic &&
+               segment->version == sharedBookVersion;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return ready;
+}
+
+unsigned int SharedBookReader::getProductCount() const {
+  return isOpen() ? segment->productCount.load(std::memory_order_acquire) : 0;
+}
+
+int SharedBookReader::findProduct(const std::string &product) const {
+  unsigned int count = getProductCount();
+  for (unsigned int i = 0; i < count; i++) {
+    const char *name = segment->slots[i].snapshot.product;
+    if (product.compare(0, std::string::npos, name,
+                        strnlen(name, sizeof(SharedBookSnapshot::product))) ==
+        0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool SharedBookReader::read(unsigned int index, SharedBookSnapshot &out,
+                            unsigned int maxRetries) {
+  if (index >= getProductCount()) {
+    return false;
+  }
+  const SharedBookSlot &slot = segment->slots[index];
+  for (unsigned int attempt = 0; attempt <= maxRetries; attempt++) {
+    std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before % 2 == 0) {
+      std::memcpy(&out, &slot.snapshot, sizeof(out));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == before) {
+        return true;
+      }
+    }
+    retries++;
+  }
+  // The sequence never settled: a stalled or dead writer
+  failedReads++;
+  return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "SharedBookLayout.hpp"
+#include <cstdint>
+#include <string>
+
+/** reads consistent snapshots from the bot's shared-memory book without
+ * system calls: a read is a copy of the slot, retried while the writer is
+ * in the middle of updating it. Any number of readers can run at once. */
+class SharedBookReader {
+public:
+  /** map the segment read-only, name as given to the publisher */
+  SharedBookReader(const std::string &name);
+  ~SharedBookReader();
+  SharedBookReader(const SharedBookReader &) = delete;
+  SharedBookReader &operator=(const SharedBookReader &) = delete;
+
+  /** true once the segment is mapped and initialised by the writer */
+  bool isOpen() const;
+  /** number of products published so far */
+  unsigned int getProductCount() const;
+  /** slot of a product, or -1 if it was not published yet */
+  int findProduct(const std::string &product) const;
+  /** copy a consistent snapshot of the slot into out. False if the slot
+   * stayed mid-update for maxRetries attempts, as when the writer stalls or
+   * dies during a write; out then holds no consistent snapshot */
+  bool read(unsigned int index, SharedBookSnapshot &out,
+            unsigned int maxRetries = defaultMaxRetries);
+  /** how often a read had to retry because of a concurrent write */
+  std::uint64_t getRetryCount() const { return retries; }
+  /** how many reads gave up after maxRetries */
+  std::uint64_t getFailedReadCount() const { return failedReads; }
+
+  /** a write takes well under a microsecond, this is far more retries than
+   * a live writer ever causes */
+  static constexpr unsigned int defaultMaxRetries = 100000;
+
+private:
+  const SharedBookSegment *segment;
+  std::uint64_t retries;
+  std::uint64_t failedReads;
+};
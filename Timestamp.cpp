@@ -0,0 +1,92 @@
+#include "Timestamp.hpp"
+#include <cstdio>
+#include <exception>
+
+namespace {
+// Reads a run of digits of the given length, throws if one is missing
+int digits(const std::string &s, std::size_t pos, std::size_t count) {
+  int value = 0;
+  for (std::size_t i = pos; i < pos + count; i++) {
+    if (i >= s.size() || s[i] < '0' || s[i] > '9') {
+      throw std::exception{};
+    }
+    value = value * 10 + (s[i] - '0');
+  }
+  return value;
+}
+} // namespace
+
+std::int64_t Timestamp::toMicros(const std::string &timestamp) {
+  // 2020/06/01 11:57:30.328127
+  int year = digits(timestamp, 0, 4);
+  int month = digits(timestamp, 5, 2);
+  int day = digits(timestamp, 8, 2);
+  int hour = digits(timestamp, 11, 2);
+  int minute = digits(timestamp, 14, 2);
+  int second = digits(timestamp, 17, 2);
+  int fraction = 0;
+  std::size_t fractionDigits = 0;
+  for (std::size_t i = 20; i < timestamp.size() && fractionDigits < 6; i++) {
+    fraction = fraction * 10 + digits(timestamp, i, 1);
+    fractionDigits++;
+  }
+  for (; fractionDigits < 6; fractionDigits++) {
+    fraction *= 10;
+  }
+  std::int64_t seconds = daysFromCivil(year, month, day) * 86400 +
+                         hour * 3600 + minute * 60 + second;
+  return seconds * 1000000 + fraction;
+}
+
+std::string Timestamp::fromMicros(std::int64_t micros) {
+  std::int64_t seconds = micros / 1000000;
+  int fraction = micros % 1000000;
+  if (fraction < 0) {
+    fraction += 1000000;
+    seconds--;
+  }
+  std::int64_t days = seconds / 86400;
+  int secondOfDay = seconds % 86400;
+  if (secondOfDay < 0) {
+    secondOfDay += 86400;
+    days--;
+  }
+  int year;
+  unsigned int month, day;
+  civilFromDays(days, year, month, day);
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%04d/%02u/%02u %02d:%02d:%02d.%06d",
+                year, month, day, secondOfDay / 3600, (secondOfDay / 60) % 60,
+                secondOfDay % 60, fraction);
+  return buffer;
+}
+
+// Howard Hinnant's days_from_civil / civil_from_days
+std::int64_t Timestamp::daysFromCivil(int year, unsigned int month,
+                                      unsigned int day) {
+  year -= month <= 2;
+  const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned int yearOfEra = static_cast<unsigned int>(year - era * 400);
+  const unsigned int dayOfYear =
+      (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const unsigned int dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+}
+
+void Timestamp::civilFromDays(std::int64_t days, int &year,
+                              unsigned int &month, unsigned int &day) {
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned int dayOfEra = static_cast<unsigned int>(days - era * 146097);
+  const unsigned int yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+      365;
+  const unsigned int dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const unsigned int monthPart = (5 * dayOfYear + 2) / 153;
+  day = dayOfYear - (153 * monthPart + 2) / 5 + 1;
+  month = monthPart < 10 ? monthPart + 3 : monthPart - 9;
+  year = static_cast<int>(yearOfEra) + static_cast<int>(era * 400) +
+         (month <= 2);
+}
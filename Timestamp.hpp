@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/** conversions between the dataset's "YYYY/MM/DD HH:MM:SS.ffffff" timestamps
+ * and microseconds since the Unix epoch (UTC) */
+class Timestamp {
+public:
+  /** microseconds since the epoch, throws on a malformed timestamp */
+  static std::int64_t toMicros(const std::string &timestamp);
+  /** dataset format of microseconds since the epoch */
+  static std::string fromMicros(std::int64_t micros);
+
+private:
+  static std::int64_t daysFromCivil(int year, unsigned int month,
+                                    unsigned int day);
+  static void civilFromDays(std::int64_t days, int &year, unsigned int &month,
+                            unsigned int &day);
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Checkpoint.hpp"
+#include "MemoryReport.hpp"
+#include "OrderBookEntry.hpp"
+#include "ProductConfig.hpp"
+#include <ostream>
+#include <string>
+
+/** base of the bot's trading strategies.
+ * A strategy derives from TradingStrategy<itself> (CRTP), so MerkelBot calls
+ * it through the template parameter of MerkelBot::run, without virtual
+ * dispatch, and can inline the per-tick callback. The derived class provides:
+ *   void onEntry(const OrderBookEntry &entry)
+ *     called for every bid the bot sees
+ *   OrderBookType onSnapshot(const OrderBookEntry &entry, std::ostream &log)
+ *     called every snapshotInterval distinct timestamps, returns the order
+ *     to place (bid or ask) or unknown to do nothing
+ *   void saveState(CheckpointWriter &out) const
+ *   void loadState(CheckpointReader &in)
+ *     write and read back the strategy's own state for checkpoints
+ *   static const char *name()
+ *     short name, checkpoints only resume into the strategy that wrote them
+ * and, if it keeps state on the heap:
+ *   std::size_t stateMemoryUsage() const
+ *     heap bytes of that state, for MemoryReport
+ */
+template <typename Derived> class TradingStrategy {
+public:
+  /** number of distinct timestamps between two snapshots */
+  static const int snapshotInterval = 10;
+
+  /** per-tick callback, returns the order the bot should place for the tick */
+  OrderBookType onTick(const OrderBookEntry &entry, std::ostream &log) {
+    // If the timestamp we are iterating on is a new timestamp i.e. different from the previous one, this will be true
+    bool isNewTimestamp = entry.timestamp != currentTimestamp;
+
+    derived().onEntry(entry);
+
+    if (!isNewTimestamp) {
+      return OrderBookType::unknown;
+    }
+    // Take note of current timestamp
+    currentTimestamp = entry.timestamp;
+    // If we are seeing a new timestamp and it's time to take a new snapshot, the strategy evaluates it
+    if (advanceCadence(timestampCounter, snapshotCounter)) {
+      return derived().onSnapshot(entry, log);
+    }
+    return OrderBookType::unknown;
+  }
+
+  /** the snapshot cadence on its own: move the counters past one new
+   * timestamp, true if that timestamp takes a snapshot */
+  static bool advanceCadence(int &timestampCounter, double &snapshotCounter) {
+    // If we have been seeing 10 different timestamps up to this moment, it's time for a new snapshot
+    if (timestampCounter == snapshotInterval) {
+      // We reset the timestamp counter, because we will be counting once again from 0 to 10 the new timestamps
+      timestampCounter = 0;
+      snapshotCounter++;
+      return true;
+    }
+    timestampCounter++;
+    return false;
+  }
+
+  /** start the cadence mid-history, where a replay from the beginning would
+   * be just after `_currentTimestamp`. The strategy's own state starts empty */
+  void prime(int _timestampCounter, double _snapshotCounter,
+             const std::string &_currentTimestamp) {
+    timestampCounter = _timestampCounter;
+    snapshotCounter = _snapshotCounter;
+    currentTimestamp = _currentTimestamp;
+  }
+
+  /** per-product parameters, resolved once before the first tick */
+  void setup(const ProductConfig &_config) { config = _config; }
+
+  /** write the strategy's full state into a checkpoint */
+  void save(CheckpointWriter &out) const {
+    out.write(timestampCounter);
+    out.write(snapshotCounter);
+    out.write(currentTimestamp);
+    derived().saveState(out);
+  }
+  /** heap bytes held by the strategy */
+  std::size_t getMemoryUsage() const {
+    return MemoryReport::stringBytes(currentTimestamp) +
+           derived().stateMemoryUsage();
+  }
+  /** strategies with state on the heap hide this */
+  std::size_t stateMemoryUsage() const { return 0; }
+
+  /** restore the state written by save */
+  void load(CheckpointReader &in) {
+    in.read(timestampCounter);
+    in.read(snapshotCounter);
+    in.read(currentTimestamp);
+    derived().loadState(in);
+  }
+
+protected:
+  Derived &derived() { return static_cast<Derived &>(*this); }
+  const Derived &derived() const { return static_cast<const Derived &>(*this); }
+
+  ProductConfig config;
+  // The Timestamp counter keeps track of the time "passing" within the orderBook
+  int timestampCounter = 0;
+  // The Snapshot counter is the number of snapshots taken so far
+  double snapshotCounter = 0;
+  std::string currentTimestamp = "";
+};
@@ -0,0 +1,35 @@
+#include "VWAPDeviationStrategy.hpp"
+
+VWAPDeviationStrategy::VWAPDeviationStrategy(double _threshold)
+    : threshold(_threshold) {}
+
+void VWAPDeviationStrategy::saveState(CheckpointWriter &out) const {
+  out.write(threshold);
+  out.write(priceVolume);
+  out.write(volume);
+}
+
+void VWAPDeviationStrategy::loadState(CheckpointReader &in) {
+  in.read(threshold);
+  in.read(priceVolume);
+  in.read(volume);
+}
+
+OrderBookType VWAPDeviationStrategy::onSnapshot(const OrderBookEntry &entry,
+                                                std::ostream &log) {
+  if (volume <= 0) {
+    return OrderBookType::unknown;
+  }
+  double vwap = priceVolume / volume;
+  double deviation = (entry.price - vwap) / vwap;
+  log << "vwapDeviation price " << entry.price << " | VWAP " << vwap
+      << " | deviation " << deviation << std::endl;
+  if (deviation < -threshold) {
+    return OrderBookType::bid;
+  }
+  if (deviation > threshold) {
+    return OrderBookType::ask;
+  }
+  log << "Price is close to the VWAP. Bot is sleeping..." << std::endl;
+  return OrderBookType::unknown;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "TradingStrategy.hpp"
+
+/** buys when the price falls a fraction below the volume weighted average
+ * price of all the bids seen so far, and sells when it rises as far above */
+class VWAPDeviationStrategy : public TradingStrategy<VWAPDeviationStrategy> {
+public:
+  /** threshold is the relative deviation from the VWAP, e.g. 0.002 */
+  VWAPDeviationStrategy(double threshold = 0.002);
+
+  void onEntry(const OrderBookEntry &entry) {
+    priceVolume += entry.price * entry.amount;
+    volume += entry.amount;
+  }
+  OrderBookType onSnapshot(const OrderBookEntry &entry, std::ostream &log);
+  void saveState(CheckpointWriter &out) const;
+  void loadState(CheckpointReader &in);
+  static const char *name() { return "vwap"; }
+
+private:
+  double threshold;
+  double priceVolume = 0;
+  double volume = 0;
+};
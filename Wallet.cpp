@@ -1,5 +1,7 @@
 #include "CSVReader.hpp"
 #include "Wallet.hpp"
+#include "Instrumentation.hpp"
+#include "MemoryReport.hpp"
 #include <iostream>
 
 Wallet::Wallet() {}
@@ -43,6 +45,10 @@ bool Wallet::containsCurrency(std::string type, double amount) {
     return currencies[type] >= amount;
 }
 
+std::size_t Wallet::getMemoryUsage() const {
+  return MemoryReport::mapBytes(currencies);
+}
+
 std::string Wallet::toString() {
   std::string s;
   for (std::pair<std::string, double> pair : currencies) {
@@ -53,7 +59,7 @@ std::string Wallet::toString() {
   return s;
 }
 
-bool Wallet::canFulfillOrder(OrderBookEntry order) {
+bool Wallet::canFulfillOrder(const OrderBookEntry &order) {
   std::vector<std::string> currs = CSVReader::tokenise(order.product, '/');
   // ask
   if (order.orderType == OrderBookType::ask) {
@@ -95,6 +101,49 @@ void Wallet::processSale(OrderBookEntry &sale) {
     currencies[outgoingCurrency] -= outgoingAmount;
   }
 }
+bool Wallet::canCommit(const WalletTransaction &transaction) {
+  for (const CurrencyDelta &d : transaction.getDeltas()) {
+    if (d.amount >= 0)
+      continue;
+    if (!containsCurrency(d.currency, -d.amount))
+      return false;
+  }
+  return true;
+}
+
+bool Wallet::commit(WalletTransaction &transaction) {
+  MERKEL_TIME_STAGE(Stage::walletUpdate);
+  bool accepted = canCommit(transaction);
+  if (accepted) {
+    for (const CurrencyDelta &d : transaction.getDeltas()) {
+      currencies[d.currency] += d.amount;
+    }
+  }
+  transaction.rollback();
+  return accepted;
+}
+
+void Wallet::save(CheckpointWriter &out) const {
+  out.write(static_cast<std::uint32_t>(currencies.size()));
+  for (auto const &c : currencies) {
+    out.write(c.first);
+    out.write(c.second);
+  }
+}
+
+void Wallet::load(CheckpointReader &in) {
+  std::uint32_t count;
+  in.read(count);
+  currencies.clear();
+  for (std::uint32_t i = 0; i < count; i++) {
+    std::string currency;
+    double amount;
+    in.read(currency);
+    in.read(amount);
+    currencies[currency] = amount;
+  }
+}
+
 std::ostream &operator<<(std::ostream &os, Wallet &wallet) {
   os << wallet.toString();
   return os;
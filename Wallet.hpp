@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Checkpoint.hpp"
 #include "OrderBookEntry.hpp"
+#include "WalletTransaction.hpp"
 #include <iostream>
 #include <map>
 #include <string>
@@ -16,11 +18,30 @@ public:
   /** check if the wallet contains this much currency or more */
   bool containsCurrency(std::string type, double amount);
   /** checks if the wallet can cope with this ask or bid.*/
-  bool canFulfillOrder(OrderBookEntry order);
+  bool canFulfillOrder(const OrderBookEntry &order);
   /** update the contents of the wallet
    * assumes the order was made by the owner of the wallet
    */
   void processSale(OrderBookEntry &sale);
+  /** check that applying the transaction leaves no currency overdrawn */
+  bool canCommit(const WalletTransaction &transaction);
+  /** apply all the changes of the transaction at once, or none of them if
+   * that would overdraw a currency. The transaction is emptied either way.
+   */
+  bool commit(WalletTransaction &transaction);
+
+  /** every currency held and its balance */
+  const std::map<std::string, double> &getBalances() const {
+    return currencies;
+  }
+
+  /** heap bytes held by the balances */
+  std::size_t getMemoryUsage() const;
+
+  /** write the balances into a checkpoint */
+  void save(CheckpointWriter &out) const;
+  /** replace the balances with the ones of a checkpoint */
+  void load(CheckpointReader &in);
 
   /** generate a string representation of the wallet */
   std::string toString();
@@ -0,0 +1,44 @@
+#include "WalletTransaction.hpp"
+#include "CSVReader.hpp"
+
+WalletTransaction::WalletTransaction() : saleCount(0) {}
+
+void WalletTransaction::addSale(const OrderBookEntry &sale) {
+  if (sale.product != splitProduct) {
+    std::vector<std::string> currs = CSVReader::tokenise(sale.product, '/');
+    if (currs.size() != 2) {
+      throw std::exception{};
+    }
+    splitProduct = sale.product;
+    baseCurrency = currs[0];
+    quoteCurrency = currs[1];
+  }
+
+  // ask: base currency goes out, quote currency comes in
+  if (sale.orderType == OrderBookType::asksale) {
+    addDelta(baseCurrency, -sale.amount);
+    addDelta(quoteCurrency, sale.amount * sale.price);
+  }
+  // bid: quote currency goes out, base currency comes in
+  if (sale.orderType == OrderBookType::bidsale) {
+    addDelta(baseCurrency, sale.amount);
+    addDelta(quoteCurrency, -sale.amount * sale.price);
+  }
+  saleCount++;
+}
+
+void WalletTransaction::rollback() {
+  deltas.clear();
+  saleCount = 0;
+}
+
+// A transaction touches a couple of currencies, a linear search is enough
+void WalletTransaction::addDelta(const std::string &currency, double amount) {
+  for (CurrencyDelta &d : deltas) {
+    if (d.currency == currency) {
+      d.amount += amount;
+      return;
+    }
+  }
+  deltas.push_back(CurrencyDelta{currency, amount});
+}
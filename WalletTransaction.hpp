@@ -0,0 +1,38 @@
+#pragma once
+
+#include "OrderBookEntry.hpp"
+#include <string>
+#include <vector>
+
+/** net change of one currency within a transaction */
+struct CurrencyDelta {
+  std::string currency;
+  double amount;
+};
+
+/** a batch of sales gathered for the wallet and applied in one commit */
+class WalletTransaction {
+public:
+  WalletTransaction();
+  /** record the currency changes a sale makes to the wallet */
+  void addSale(const OrderBookEntry &sale);
+  /** discard all the changes gathered so far */
+  void rollback();
+  /** true if no sale has been gathered */
+  bool empty() const { return deltas.empty(); }
+  /** number of sales gathered */
+  unsigned int getSaleCount() const { return saleCount; }
+  /** one net delta per currency touched by the gathered sales */
+  const std::vector<CurrencyDelta> &getDeltas() const { return deltas; }
+
+private:
+  void addDelta(const std::string &currency, double amount);
+
+  std::vector<CurrencyDelta> deltas;
+  unsigned int saleCount;
+  // The product of the previous sale and its split currencies
+  // Fills of one match share a product, so it is only tokenised once
+  std::string splitProduct;
+  std::string baseCurrency;
+  std::string quoteCurrency;
+};
@@ -1,8 +1,14 @@
+#include "HeadlessMain.hpp"
 #include "MerkelMain.hpp"
 #include "Wallet.hpp"
 #include <iostream>
 
-int main() {
+int main(int argc, char *argv[]) {
+  // Any command line option runs the bot headless, without the menu
+  if (HeadlessMain::isHeadless(argc, argv)) {
+    HeadlessMain headless{argc, argv};
+    return headless.run();
+  }
   MerkelMain app{};
   app.init();
 }
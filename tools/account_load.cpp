@@ -0,0 +1,148 @@
+// Drives N simulated accounts through the order book: every round, each
+// account places one bid or ask around a mid price at a new timestamp, the
+// bucket is matched and the fills are settled in an AccountLedger. Matching
+// and settlement throughput are reported for every account count.
+//
+//   account_load [--accounts 10,100,1000,10000] [--rounds 20] [--seed 1]
+//
+// Accounts only trade with each other, so the ledger's totals must come out
+// unchanged.
+
+#include "AccountLedger.hpp"
+#include "CSVReader.hpp"
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include "Timestamp.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: account_load [--accounts N,N,...] [--rounds R] "
+               "[--seed S]"
+            << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+struct LoadResult {
+  std::size_t orders = 0;
+  std::size_t fills = 0;
+  std::size_t rejected = 0;
+  double matchSeconds = 0;
+  double settleSeconds = 0;
+  bool conserved = false;
+};
+
+LoadResult runLoad(unsigned int accountCount, unsigned int rounds,
+                   unsigned int seed) {
+  const std::string product = "BTC/USDT";
+  const double mid = 9400;
+  AccountLedger ledger{{"BTC", "USDT"}};
+  int btc = ledger.currencyIndex("BTC");
+  int usdt = ledger.currencyIndex("USDT");
+  std::vector<AccountId> accounts;
+  for (unsigned int i = 0; i < accountCount; i++) {
+    AccountId id = ledger.addAccount();
+    ledger.deposit(id, btc, 10);
+    ledger.deposit(id, usdt, 100000);
+    accounts.push_back(id);
+  }
+  double btcTotal = ledger.getTotal(btc);
+  double usdtTotal = ledger.getTotal(usdt);
+
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<double> spread{-0.005, 0.005};
+  std::uniform_real_distribution<double> size{0.01, 1};
+  std::bernoulli_distribution buying{0.5};
+
+  OrderBook orderBook;
+  LoadResult result;
+  const std::int64_t start = Timestamp::toMicros("2020/06/01 00:00:00.000000");
+  for (unsigned int r = 0; r < rounds; r++) {
+    std::string timestamp = Timestamp::fromMicros(start + r * 1000000LL);
+    for (AccountId id : accounts) {
+      orderBook.insertOrder(OrderBookEntry{
+          mid * (1 + spread(random)), size(random), timestamp, product,
+          buying(random) ? OrderBookType::bid : OrderBookType::ask, id});
+    }
+    result.orders += accounts.size();
+
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    std::vector<OrderBookEntry> sales =
+        orderBook.matchAsksToBids(product, timestamp);
+    result.matchSeconds += secondsSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (const OrderBookEntry &sale : sales) {
+      if (!ledger.settle(sale)) {
+        result.rejected++;
+      }
+    }
+    result.settleSeconds += secondsSince(begin);
+    result.fills += sales.size();
+  }
+  // Money only moves between accounts, up to rounding
+  result.conserved =
+      std::fabs(ledger.getTotal(btc) - btcTotal) <= 1e-6 * btcTotal &&
+      std::fabs(ledger.getTotal(usdt) - usdtTotal) <= 1e-6 * usdtTotal;
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::vector<unsigned int> accountCounts{10, 100, 1000, 10000};
+  unsigned int rounds = 20;
+  unsigned int seed = 1;
+  try {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      std::string arg = argv[i];
+      if (arg == "--accounts") {
+        accountCounts.clear();
+        for (const std::string &n : CSVReader::tokenise(argv[i + 1], ',')) {
+          accountCounts.push_back(std::stoul(n));
+        }
+      } else if (arg == "--rounds") {
+        rounds = std::stoul(argv[i + 1]);
+      } else if (arg == "--seed") {
+        seed = std::stoul(argv[i + 1]);
+      } else {
+        printUsage();
+        return 1;
+      }
+    }
+  } catch (const std::exception &e) {
+    printUsage();
+    return 1;
+  }
+
+  bool conserved = true;
+  std::cout << "accounts | orders | fills | match orders/s | settle fills/s"
+            << std::endl;
+  for (unsigned int accountCount : accountCounts) {
+    LoadResult result = runLoad(accountCount, rounds, seed);
+    conserved = conserved && result.conserved;
+    std::cout << accountCount << " | " << result.orders << " | "
+              << result.fills << " | "
+              << result.orders / result.matchSeconds << " | "
+              << result.fills / result.settleSeconds;
+    if (result.rejected > 0) {
+      std::cout << " | " << result.rejected << " rejected";
+    }
+    std::cout << (result.conserved ? "" : " | BALANCES NOT CONSERVED")
+              << std::endl;
+  }
+  return conserved ? 0 : 1;
+}
@@ -0,0 +1,278 @@
+// Writes synthetic order book data in the day-file format the bot reads,
+// timestamp,product,type,price,amount, for scaling tests well beyond a
+// single day of real data.
+//
+//   dataset_gen --out big.csv [--timestamps 17280] [--interval-ms 5000]
+//               [--depth 50] [--products BTC/USDT,ETH/BTC:0.025]
+//               [--volatility 0.0005] [--spread 0.001] [--persistence 0]
+//               [--seed 1] [--start "2020/06/01 00:00:00.000000"]
+//   dataset_gen --out-dir days/ ...   one YYYYMMDD.csv per day, for --data-dir
+//
+// Every product's mid price follows a geometric random walk with the given
+// per-timestamp volatility. Each timestamp gets `depth` asks above and
+// `depth` bids below the mid, spread out from the half spread, with
+// exponentially distributed amounts. Prices are rounded to the product's
+// price step from ProductRegistry.hpp, and asks are kept at least one step
+// above the mid and bids one step below it, so a spread narrower than the
+// step never locks or crosses the book. With --persistence P, each level
+// stays at its price into the next timestamp with probability P, and then
+// keeps its amount half of the time, the way a real book changes a little
+// from one timestamp to the next. The output only depends on the
+// arguments: the random numbers come from std::mt19937_64 and are turned
+// into distributions here, not by the standard library.
+
+#include "CSVReader.hpp"
+#include "ProductRegistry.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: dataset_gen (--out FILE | --out-dir DIR) "
+               "[--timestamps N] [--interval-ms MS] [--depth D] "
+               "[--products SYMBOL[:PRICE],...] [--volatility V] "
+               "[--spread S] [--persistence P] [--seed S] "
+               "[--start TIMESTAMP]"
+            << std::endl;
+}
+
+struct GeneratedProduct {
+  std::string symbol;
+  double mid;
+  double priceStep;
+  // Price and amount of every level of the previous timestamp, asks then bids
+  std::vector<double> prices;
+  std::vector<double> amounts;
+};
+
+// Starting mid of the products the bot knows, when none is given
+double defaultMid(const std::string &symbol) {
+  if (symbol == "BTC/USDT") {
+    return 9400;
+  }
+  if (symbol == "ETH/BTC") {
+    return 0.025;
+  }
+  if (symbol == "DOGE/BTC") {
+    return 3e-7;
+  }
+  return 100;
+}
+
+// Uniform in (0, 1) from the top 53 bits
+double uniform(std::mt19937_64 &random) {
+  return ((random() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// Box-Muller, one of the pair is enough here
+double normal(std::mt19937_64 &random) {
+  double u1 = uniform(random);
+  double u2 = uniform(random);
+  return std::sqrt(-2 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+/** buffered file output, written in large blocks */
+class RowWriter {
+public:
+  ~RowWriter() { close(); }
+  bool open(const std::string &path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    return file != nullptr;
+  }
+  void close() {
+    flush();
+    if (file != nullptr) {
+      std::fclose(file);
+      file = nullptr;
+    }
+  }
+  void append(const std::string &text) { buffer += text; }
+  void append(char c) { buffer += c; }
+  // Fixed point with 8 decimals, like the real data
+  void append(double value) {
+    char digits[64];
+    std::to_chars_result r = std::to_chars(
+        digits, digits + sizeof(digits), value, std::chars_format::fixed, 8);
+    buffer.append(digits, r.ptr);
+  }
+  void endRow() {
+    buffer += '\n';
+    if (buffer.size() >= 1 << 20) {
+      flush();
+    }
+  }
+  std::uint64_t getBytes() const { return bytes; }
+
+private:
+  void flush() {
+    if (file != nullptr && !buffer.empty()) {
+      std::fwrite(buffer.data(), 1, buffer.size(), file);
+    }
+    bytes += buffer.size();
+    buffer.clear();
+  }
+
+  std::FILE *file = nullptr;
+  std::string buffer;
+  std::uint64_t bytes = 0;
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string outFile;
+  std::string outDirectory;
+  std::uint64_t timestamps = 17280;
+  std::int64_t intervalMicros = 5000000;
+  unsigned int depth = 50;
+  std::string productList = "BTC/USDT,ETH/BTC,DOGE/BTC";
+  double volatility = 0.0005;
+  double spread = 0.001;
+  double persistence = 0;
+  std::uint64_t seed = 1;
+  std::string start = "2020/06/01 00:00:00.000000";
+  std::vector<GeneratedProduct> products;
+  std::int64_t startMicros;
+  try {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      std::string arg = argv[i];
+      std::string value = argv[i + 1];
+      if (arg == "--out") {
+        outFile = value;
+      } else if (arg == "--out-dir") {
+        outDirectory = value;
+      } else if (arg == "--timestamps") {
+        timestamps = std::stoull(value);
+      } else if (arg == "--interval-ms") {
+        intervalMicros = std::stoll(value) * 1000;
+      } else if (arg == "--depth") {
+        depth = std::stoul(value);
+      } else if (arg == "--products") {
+        productList = value;
+      } else if (arg == "--volatility") {
+        volatility = std::stod(value);
+      } else if (arg == "--spread") {
+        spread = std::stod(value);
+      } else if (arg == "--persistence") {
+        persistence = std::stod(value);
+      } else if (arg == "--seed") {
+        seed = std::stoull(value);
+      } else if (arg == "--start") {
+        start = value;
+      } else {
+        printUsage();
+        return 1;
+      }
+    }
+    for (const std::string &p : CSVReader::tokenise(productList, ',')) {
+      std::vector<std::string> parts = CSVReader::tokenise(p, ':');
+      GeneratedProduct product{parts[0], defaultMid(parts[0]), 1e-8, {}, {}};
+      if (parts.size() > 1) {
+        product.mid = std::stod(parts[1]);
+      }
+      ProductId id = productForSymbol(parts[0]);
+      if (isKnownProduct(id)) {
+        product.priceStep = productSpec(id).priceScale;
+      }
+      products.push_back(product);
+    }
+    startMicros = Timestamp::toMicros(start);
+  } catch (const std::exception &e) {
+    printUsage();
+    return 1;
+  }
+  if ((outFile.empty() == outDirectory.empty()) || products.empty() ||
+      intervalMicros <= 0 || depth == 0) {
+    printUsage();
+    return 1;
+  }
+
+  std::mt19937_64 random{seed};
+  RowWriter writer;
+  if (!outFile.empty() && !writer.open(outFile)) {
+    std::cout << "dataset_gen cannot write " << outFile << std::endl;
+    return 1;
+  }
+  const std::int64_t microsPerDay = 86400000000LL;
+  std::int64_t currentDay = -1;
+  std::uint64_t rows = 0;
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  for (std::uint64_t t = 0; t < timestamps; t++) {
+    std::int64_t micros = startMicros + std::int64_t(t) * intervalMicros;
+    std::string timestamp = Timestamp::fromMicros(micros);
+    // A new file whenever the day changes, named after it
+    if (!outDirectory.empty() && micros / microsPerDay != currentDay) {
+      currentDay = micros / microsPerDay;
+      std::string day = timestamp.substr(0, 4) + timestamp.substr(5, 2) +
+                        timestamp.substr(8, 2);
+      std::string path = outDirectory + "/" + day + ".csv";
+      if (!writer.open(path)) {
+        std::cout << "dataset_gen cannot write " << path << std::endl;
+        return 1;
+      }
+    }
+    for (GeneratedProduct &product : products) {
+      product.mid *= std::exp(volatility * normal(random) -
+                              volatility * volatility / 2);
+      product.prices.resize(2 * depth);
+      product.amounts.resize(2 * depth);
+      for (int side = 0; side < 2; side++) {
+        bool ask = side == 0;
+        for (unsigned int level = 0; level < depth; level++) {
+          double &price = product.prices[side * depth + level];
+          double &amount = product.amounts[side * depth + level];
+          // No random number is drawn for persistence 0, so those files do
+          // not depend on the option
+          if (persistence > 0 && t > 0 && uniform(random) < persistence) {
+            if (uniform(random) < 0.5) {
+              amount = -std::log(uniform(random));
+            }
+          } else {
+            // Levels fan out from the half spread, a little further each time
+            double distance =
+                spread / 2 * (1 + level * (0.5 + uniform(random)));
+            price = product.mid * (ask ? 1 + distance : 1 - distance);
+            price = std::round(price / product.priceStep) * product.priceStep;
+            amount = -std::log(uniform(random));
+          }
+          // Also moves a persisting level the mid has walked through
+          const double step = product.priceStep;
+          if (ask) {
+            price = std::max(price, std::ceil((product.mid + step) / step) * step);
+          } else {
+            price = std::min(price, std::floor((product.mid - step) / step) * step);
+          }
+          writer.append(timestamp);
+          writer.append(',');
+          writer.append(product.symbol);
+          writer.append(ask ? ",ask," : ",bid,");
+          writer.append(price);
+          writer.append(',');
+          writer.append(amount);
+          writer.endRow();
+          rows++;
+        }
+      }
+    }
+  }
+  writer.close();
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+          .count();
+  std::cout << rows << " rows, " << writer.getBytes() / 1e6 << " MB in "
+            << seconds << " s (" << rows / seconds / 1e6 << " M rows/s)"
+            << std::endl;
+  return 0;
+}
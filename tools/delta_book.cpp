@@ -0,0 +1,157 @@
+// Measures DeltaBookStore on a day file: memory against the full buckets of
+// OrderBook, and the cost of rebuilding buckets in order and at random, for
+// a few keyframe intervals. Every rebuilt bucket is checked against the
+// file's own.
+//
+//   delta_book --data 20200601.csv [--keyframes 1,16,64,256] [--reads 2000]
+
+#include "CSVReader.hpp"
+#include "DeltaBookStore.hpp"
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: delta_book --data FILE [--keyframes K,K,...] "
+               "[--reads R]"
+            << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Same orders, whatever their order in the bucket
+bool sameOrders(std::vector<OrderBookEntry> expected,
+                std::vector<OrderBookEntry> got) {
+  auto less = [](const OrderBookEntry &e1, const OrderBookEntry &e2) {
+    if (e1.product != e2.product) {
+      return e1.product < e2.product;
+    }
+    if (e1.orderType != e2.orderType) {
+      return e1.orderType < e2.orderType;
+    }
+    if (e1.price != e2.price) {
+      return e1.price < e2.price;
+    }
+    return e1.amount < e2.amount;
+  };
+  std::sort(expected.begin(), expected.end(), less);
+  std::sort(got.begin(), got.end(), less);
+  if (expected.size() != got.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < got.size(); i++) {
+    if (expected[i].price != got[i].price ||
+        expected[i].amount != got[i].amount ||
+        expected[i].product != got[i].product ||
+        expected[i].orderType != got[i].orderType ||
+        expected[i].timestamp != got[i].timestamp) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  std::vector<unsigned int> intervals{1, 16, 64, 256};
+  unsigned int reads = 2000;
+  try {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      std::string arg = argv[i];
+      if (arg == "--data") {
+        dataFile = argv[i + 1];
+      } else if (arg == "--keyframes") {
+        intervals.clear();
+        for (const std::string &k : CSVReader::tokenise(argv[i + 1], ',')) {
+          intervals.push_back(std::stoul(k));
+        }
+      } else if (arg == "--reads") {
+        reads = std::stoul(argv[i + 1]);
+      } else {
+        printUsage();
+        return 1;
+      }
+    }
+  } catch (const std::exception &e) {
+    printUsage();
+    return 1;
+  }
+  if (dataFile.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  std::map<std::string, std::vector<OrderBookEntry>> buckets =
+      CSVReader::readCSVMap(dataFile);
+  OrderBook orderBook{dataFile};
+  std::size_t fullBytes = orderBook.getMemoryUsage();
+  std::cout << buckets.size() << " timestamps, OrderBook "
+            << fullBytes / 1e6 << " MB" << std::endl;
+
+  unsigned int mismatches = 0;
+  for (unsigned int interval : intervals) {
+    DeltaBookStore store{interval};
+    for (auto const &b : buckets) {
+      store.append(b.first, b.second);
+    }
+    const std::vector<std::string> &timestamps = store.getTimestamps();
+
+    for (const std::string &timestamp : timestamps) {
+      if (!sameOrders(buckets[timestamp], store.getBucket(timestamp))) {
+        mismatches++;
+      }
+    }
+
+    // In order, the way a replay reads
+    std::chrono::steady_clock::time_point timed =
+        std::chrono::steady_clock::now();
+    std::size_t orderCount = 0;
+    for (const std::string &timestamp : timestamps) {
+      orderCount += store.getBucket(timestamp).size();
+    }
+    double sequentialSeconds = secondsSince(timed);
+
+    // At random, each read rebuilding from its keyframe
+    std::mt19937 random{1};
+    std::uniform_int_distribution<std::size_t> pick{0, timestamps.size() - 1};
+    std::vector<std::string> picked;
+    for (unsigned int r = 0; r < reads; r++) {
+      picked.push_back(timestamps[pick(random)]);
+    }
+    std::uint64_t stepsBefore = store.getStepsApplied();
+    timed = std::chrono::steady_clock::now();
+    for (const std::string &timestamp : picked) {
+      orderCount += store.getBucket(timestamp).size();
+    }
+    double randomSeconds = secondsSince(timed);
+
+    std::size_t bytes = store.getMemoryUsage();
+    std::cout << "keyframe every " << interval << ": " << bytes / 1e6
+              << " MB (" << 100.0 * bytes / fullBytes << "% of OrderBook), "
+              << "in order " << sequentialSeconds / timestamps.size() * 1e6
+              << " us/bucket, random "
+              << randomSeconds / picked.size() * 1e6 << " us/bucket ("
+              << double(store.getStepsApplied() - stepsBefore) / picked.size()
+              << " deltas applied)" << std::endl;
+    // Keeps the reads from being optimised away
+    if (orderCount == 0) {
+      mismatches++;
+    }
+  }
+  std::cout << "mismatched buckets: " << mismatches << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
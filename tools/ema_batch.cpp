@@ -0,0 +1,197 @@
+// Screens EMA parameter sets over a day file with the batch calculations of
+// EMACalculator, checks them against the streaming strategy and times both.
+//
+//   ema_batch --data 20200601.csv [--periods 64] [--repeat 200]
+//
+// Every product gets one series with the strategy's own (unbounded) period
+// and periods - 1 series with periods 2, 3, ... The unbounded series must
+// match EMACrossoverStrategy bit for bit, EMAs and orders alike.
+
+#include "EMACalculator.hpp"
+#include "EMACrossoverStrategy.hpp"
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include "ProductConfig.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: ema_batch --data FILE [--periods N] [--repeat R]"
+            << std::endl;
+}
+
+// What the streaming strategy does with one product's bids
+struct StreamingRun {
+  std::vector<double> movingAverages;
+  std::vector<std::int8_t> orders;
+};
+
+StreamingRun runStreaming(const std::vector<OrderBookEntry> &bids,
+                          const ProductConfig &config) {
+  std::ostream discard{nullptr};
+  EMACrossoverStrategy strategy;
+  strategy.setup(config);
+  StreamingRun run;
+  for (const OrderBookEntry &entry : bids) {
+    OrderBookType action = strategy.onTick(entry, discard);
+    if (action == OrderBookType::bid) {
+      run.orders.push_back(EMACalculator::buy);
+    } else if (action == OrderBookType::ask) {
+      run.orders.push_back(EMACalculator::sell);
+    }
+  }
+  run.movingAverages = strategy.getMovingAverages();
+  return run;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  unsigned int periodCount = 64;
+  unsigned int repeat = 200;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--periods") {
+      periodCount = std::stoul(argv[i + 1]);
+    } else if (arg == "--repeat") {
+      repeat = std::stoul(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (dataFile.empty() || periodCount == 0) {
+    printUsage();
+    return 1;
+  }
+
+  OrderBook orderBook{dataFile};
+  std::vector<ProductConfig> configs;
+  std::vector<std::vector<OrderBookEntry>> bids;
+  std::vector<double> seeds;
+  std::vector<std::vector<double>> inputs;
+  std::size_t steps = std::numeric_limits<std::size_t>::max();
+  for (const std::string &product : orderBook.getKnownProducts()) {
+    ProductConfig config = ProductConfig::forProduct(product);
+    if (!config.isValid()) {
+      continue;
+    }
+    configs.push_back(config);
+    bids.push_back(
+        orderBook.getOrdersByTypeAndProduct(OrderBookType::bid, product));
+    seeds.push_back(0);
+    inputs.emplace_back();
+    EMACrossoverStrategy::snapshotInputs(bids.back(), seeds.back(),
+                                         inputs.back());
+    steps = std::min(steps, inputs.back().size());
+  }
+  if (configs.empty() || steps == 0) {
+    std::cout << "ema_batch no snapshots to work on" << std::endl;
+    return 1;
+  }
+
+  // Series s is product s / periodCount with period s % periodCount
+  std::size_t seriesCount = configs.size() * periodCount;
+  std::vector<double> prices(steps * seriesCount);
+  std::vector<double> seriesSeeds(seriesCount);
+  std::vector<double> periods(seriesCount);
+  std::vector<double> bidDeltas(seriesCount);
+  std::vector<double> askDeltas(seriesCount);
+  for (std::size_t s = 0; s < seriesCount; s++) {
+    std::size_t p = s / periodCount;
+    std::size_t k = s % periodCount;
+    seriesSeeds[s] = seeds[p];
+    periods[s] = k == 0 ? std::numeric_limits<double>::infinity() : k + 1;
+    bidDeltas[s] = configs[p].bidDelta;
+    askDeltas[s] = configs[p].askDelta;
+    for (std::size_t t = 0; t < steps; t++) {
+      prices[t * seriesCount + s] = inputs[p][t];
+    }
+  }
+
+  std::vector<float> emas(steps * seriesCount);
+  std::vector<std::int8_t> signals(steps * seriesCount);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    EMACalculator::ema(prices.data(), steps, seriesCount, seriesSeeds.data(),
+                       2, periods.data(), emas.data());
+    EMACalculator::crossover(emas.data(), steps, seriesCount,
+                             seriesSeeds.data(), bidDeltas.data(),
+                             askDeltas.data(), signals.data());
+  }
+  double batchSeconds = secondsSince(start);
+
+  // The same EMAs one series after the other, the way a streaming loop does
+  std::vector<float> scalarEmas(steps * seriesCount);
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (std::size_t s = 0; s < seriesCount; s++) {
+      float ema = seriesSeeds[s];
+      for (std::size_t t = 0; t < steps; t++) {
+        double factor = EMACalculator::smoothing(2.0 + t, periods[s]);
+        ema = EMACalculator::step(ema, prices[t * seriesCount + s], factor);
+        scalarEmas[t * seriesCount + s] = ema;
+      }
+    }
+  }
+  double scalarSeconds = secondsSince(start);
+
+  // Bit for bit checks of the unbounded series against the strategy
+  unsigned int mismatches = 0;
+  for (std::size_t p = 0; p < configs.size(); p++) {
+    StreamingRun streaming = runStreaming(bids[p], configs[p]);
+    std::size_t s = p * periodCount;
+    std::vector<std::int8_t> orders;
+    for (std::size_t t = 0; t < steps; t++) {
+      float expected = streaming.movingAverages[t + 1];
+      float got = emas[t * seriesCount + s];
+      if (std::memcmp(&expected, &got, sizeof(float)) != 0) {
+        mismatches++;
+      }
+      if (signals[t * seriesCount + s] != EMACalculator::hold) {
+        orders.push_back(signals[t * seriesCount + s]);
+      }
+    }
+    bool sameOrders = inputs[p].size() != steps || orders == streaming.orders;
+    if (!sameOrders) {
+      mismatches++;
+    }
+    std::cout << configs[p].product << ": " << inputs[p].size()
+              << " snapshots, " << orders.size() << " orders"
+              << (sameOrders ? "" : " differing from the strategy")
+              << std::endl;
+  }
+  if (std::memcmp(emas.data(), scalarEmas.data(),
+                  emas.size() * sizeof(float)) != 0) {
+    mismatches++;
+  }
+
+  double elements = double(steps) * seriesCount * repeat;
+  std::cout << seriesCount << " series x " << steps << " steps, " << repeat
+            << " times" << std::endl;
+  std::cout << "batch EMA + crossover: " << elements / batchSeconds / 1e6
+            << " M/s" << std::endl;
+  std::cout << "one series at a time:  " << elements / scalarSeconds / 1e6
+            << " M/s" << std::endl;
+  std::cout << "mismatches against the streaming strategy: " << mismatches
+            << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
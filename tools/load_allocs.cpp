@@ -0,0 +1,89 @@
+// Counts the heap allocations made per row while a day file loads, through
+// CSVReader::readCSV, CSVReader::readCSVMap and a whole OrderBook, by
+// replacing operator new the way a -DMERKEL_INSTRUMENT build does.
+// Fails (exit code 1) if a loader makes more than --max allocations per row
+// on average.
+//
+//   load_allocs --data 20200601.csv [--max 3]
+
+#include "CSVReader.hpp"
+#include "OrderBook.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+std::atomic<std::uint64_t> allocations{0};
+
+void printUsage() {
+  std::cout << "Usage: load_allocs --data FILE [--max N]" << std::endl;
+}
+
+// Allocations per row of one loader, false if above the limit
+bool report(const char *name, std::uint64_t count, std::size_t rows,
+            double max) {
+  double perRow = rows == 0 ? 0 : double(count) / rows;
+  std::cout << name << ": " << count << " allocations for " << rows
+            << " rows, " << perRow << " per row" << std::endl;
+  return perRow <= max;
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  double max = 3;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--max") {
+      max = std::stod(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (dataFile.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  bool passed = true;
+  std::uint64_t before = allocations.load();
+  std::size_t rows = CSVReader::readCSV(dataFile).size();
+  passed &= report("readCSV", allocations.load() - before, rows, max);
+
+  before = allocations.load();
+  std::map<std::string, std::vector<OrderBookEntry>> buckets =
+      CSVReader::readCSVMap(dataFile);
+  std::uint64_t mapAllocations = allocations.load() - before;
+  rows = 0;
+  for (const auto &bucket : buckets) {
+    rows += bucket.second.size();
+  }
+  passed &= report("readCSVMap", mapAllocations, rows, max);
+
+  before = allocations.load();
+  OrderBook orderBook{dataFile};
+  passed &= report("OrderBook", allocations.load() - before,
+                   orderBook.getOrderCount(), max);
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// Fill throughput of OrderBook::matchAsksToBids with the sale context kept as
+// numbers, against the same matches with the context text the matcher used
+// to build: once per match, four std::to_string calls, then a copy of the
+// string into every sale. Every product of every timestamp of a day file is
+// matched, --repeat times.
+//
+//   match_bench --data 20200601.csv [--repeat 20]
+
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: match_bench --data FILE [--repeat R]" << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  unsigned int repeat = 20;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--repeat") {
+      repeat = std::stoul(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (dataFile.empty() || repeat == 0) {
+    printUsage();
+    return 1;
+  }
+
+  OrderBook orderBook{dataFile};
+  std::vector<std::pair<std::string, std::string>> books;
+  std::vector<std::string> products = orderBook.getKnownProducts();
+  std::string earliest = orderBook.getEarliestTime();
+  std::string timestamp = earliest;
+  do {
+    for (const std::string &product : products) {
+      books.push_back({timestamp, product});
+    }
+    timestamp = orderBook.getNextTime(timestamp);
+  } while (timestamp != earliest);
+
+  // Typed context, as the matcher works now
+  std::uint64_t fills = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (const auto &book : books) {
+      fills += orderBook.matchAsksToBids(book.second, book.first).size();
+    }
+  }
+  double typedSeconds = secondsSince(start);
+
+  // The same, plus the text every match used to carry into its sales
+  std::uint64_t textBytes = 0;
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (const auto &book : books) {
+      std::vector<OrderBookEntry> sales =
+          orderBook.matchAsksToBids(book.second, book.first);
+      const BookSnapshot &snapshot =
+          orderBook.getSnapshot(book.second, book.first);
+      std::string controlString =
+          "max ask: " + std::to_string(snapshot.maxAsk) +
+          " | min ask: " + std::to_string(snapshot.minAsk) +
+          " | max bid: " + std::to_string(snapshot.maxBid) +
+          " | min bid: " + std::to_string(snapshot.minBid);
+      std::vector<std::string> saleStrings(sales.size(), controlString);
+      for (const std::string &s : saleStrings) {
+        textBytes += s.size();
+      }
+    }
+  }
+  double textSeconds = secondsSince(start);
+
+  std::cout << books.size() * repeat << " matches, " << fills << " fills"
+            << std::endl;
+  std::cout << "context as text:    " << fills / textSeconds << " fills/s"
+            << std::endl;
+  std::cout << "context as numbers: " << fills / typedSeconds
+            << " fills/s (" << textSeconds / typedSeconds << "x)" << std::endl;
+  // Printed so the text cannot be optimised away
+  std::cout << textBytes << " bytes of context text" << std::endl;
+  return 0;
+}
@@ -0,0 +1,273 @@
+// Differential check and benchmark of OrderBook::matchAsksToBidsFast against
+// the reference, OrderBook::matchAsksToBids. Both match the same books and
+// every fill is compared field by field, prices and amounts bit for bit;
+// the first difference is printed with the book it came from and the exit
+// code is 1.
+//
+//   match_diff [--books 1000000] [--seed 1] [--data 20200601.csv]
+//              [--repeat 1]
+//
+// The random books are single buckets built to reach the edge cases of the
+// matcher: prices on a coarse grid so they tie, amounts from a short list
+// so bids and asks often match exactly, zero amounts, one-sided books, and
+// orders of the simuser and bot accounts. With --data every product of
+// every timestamp of a day file is matched too, --repeat times. Prices are
+// numbers: with a NaN price the sort of the reference has no defined
+// order to agree with.
+
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include "Timestamp.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: match_diff [--books N] [--seed S] [--data FILE] "
+               "[--repeat R]"
+            << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Uniform in [0, 1) from the top 53 bits
+double uniform(std::mt19937_64 &random) {
+  return (random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Bit for bit, so 0 and -0 differ
+bool sameDouble(double a, double b) {
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+bool sameFill(const OrderBookEntry &a, const OrderBookEntry &b) {
+  return sameDouble(a.price, b.price) && sameDouble(a.amount, b.amount) &&
+         a.timestamp == b.timestamp && a.product == b.product &&
+         a.orderType == b.orderType && a.accountId == b.accountId &&
+         a.counterpartyId == b.counterpartyId &&
+         sameDouble(a.context.maxAsk, b.context.maxAsk) &&
+         sameDouble(a.context.minAsk, b.context.minAsk) &&
+         sameDouble(a.context.maxBid, b.context.maxBid) &&
+         sameDouble(a.context.minBid, b.context.minBid);
+}
+
+const char *typeName(OrderBookType type) {
+  switch (type) {
+  case OrderBookType::bid:
+    return "bid";
+  case OrderBookType::ask:
+    return "ask";
+  case OrderBookType::asksale:
+    return "asksale";
+  case OrderBookType::bidsale:
+    return "bidsale";
+  default:
+    return "unknown";
+  }
+}
+
+void printFill(const char *label, const OrderBookEntry &e) {
+  std::cout << "  " << label << " " << typeName(e.orderType)
+            << " price " << e.price << " amount " << e.amount << " account "
+            << e.accountId << " counterparty " << e.counterpartyId
+            << std::endl;
+}
+
+// The first difference between the fill streams of a book, or nothing
+bool compareFills(const std::vector<OrderBookEntry> &reference,
+                  const std::vector<OrderBookEntry> &fast,
+                  const std::vector<OrderBookEntry> &bucket,
+                  const std::string &product) {
+  std::size_t i = 0;
+  while (i < reference.size() && i < fast.size() &&
+         sameFill(reference[i], fast[i])) {
+    i++;
+  }
+  if (i == reference.size() && i == fast.size()) {
+    return true;
+  }
+  std::cout << "Fills differ at fill " << i << " of " << product << " at "
+            << (bucket.empty() ? "" : bucket[0].timestamp) << ": reference "
+            << reference.size() << " fills, fast " << fast.size() << std::endl;
+  if (i < reference.size()) {
+    printFill("reference", reference[i]);
+  }
+  if (i < fast.size()) {
+    printFill("fast     ", fast[i]);
+  }
+  std::cout << "Book:" << std::endl;
+  for (const OrderBookEntry &e : bucket) {
+    if (e.product == product) {
+      std::cout << "  " << typeName(e.orderType)
+                << " " << e.price << " " << e.amount << " account "
+                << e.accountId << std::endl;
+    }
+  }
+  return false;
+}
+
+// One random order of a book around a price of 100, asks a little above
+// the bids so about half of each side crosses
+OrderBookEntry randomOrder(std::mt19937_64 &random, const std::string &timestamp,
+                           const std::string &product, OrderBookType type) {
+  static const double amounts[] = {0.5, 1, 1, 1.5, 2, 2.5, 3};
+  int tick = static_cast<int>(uniform(random) * 16);
+  double price = type == OrderBookType::ask ? 100 + (tick - 5) * 0.25
+                                            : 100 - (tick - 5) * 0.25;
+  double draw = uniform(random);
+  double amount = draw < 0.02   ? 0
+                  : draw < 0.85 ? amounts[random() % 7]
+                                : uniform(random) * 4;
+  double account = uniform(random);
+  AccountId accountId = account < 0.9    ? datasetAccount
+                        : account < 0.95 ? simuserAccount
+                                         : botAccount;
+  return OrderBookEntry{price, amount, timestamp, product, type, accountId};
+}
+
+struct Totals {
+  std::uint64_t books = 0;
+  std::uint64_t fills = 0;
+  double referenceSeconds = 0;
+  double fastSeconds = 0;
+};
+
+// Matches every book with both matchers, timing each over all the books,
+// then compares. The books are (timestamp, product) pairs of the order book
+bool matchBooks(OrderBook &orderBook,
+                const std::vector<std::pair<std::string, std::string>> &books,
+                unsigned int repeat, Totals &totals) {
+  std::vector<std::vector<OrderBookEntry>> reference(books.size());
+  std::vector<std::vector<OrderBookEntry>> fast(books.size());
+  // The reference prints a line for one-sided books, which is not what is
+  // timed
+  std::streambuf *console = std::cout.rdbuf(nullptr);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (std::size_t i = 0; i < books.size(); i++) {
+      reference[i] = orderBook.matchAsksToBids(books[i].second, books[i].first);
+    }
+  }
+  totals.referenceSeconds += secondsSince(start);
+  std::cout.rdbuf(console);
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (std::size_t i = 0; i < books.size(); i++) {
+      fast[i] = orderBook.matchAsksToBidsFast(books[i].second, books[i].first);
+    }
+  }
+  totals.fastSeconds += secondsSince(start);
+
+  for (std::size_t i = 0; i < books.size(); i++) {
+    if (!compareFills(reference[i], fast[i],
+                      orderBook.getBucket(books[i].first), books[i].second)) {
+      return false;
+    }
+    totals.fills += reference[i].size() * repeat;
+  }
+  totals.books += books.size() * repeat;
+  return true;
+}
+
+void printTotals(const char *name, const Totals &totals) {
+  std::cout << name << ": " << totals.books << " books, " << totals.fills
+            << " fills, identical" << std::endl;
+  std::cout << "  reference " << totals.referenceSeconds << " s, fast "
+            << totals.fastSeconds << " s, speedup "
+            << totals.referenceSeconds / totals.fastSeconds << "x"
+            << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::uint64_t bookCount = 1000000;
+  std::uint64_t seed = 1;
+  std::string dataFile;
+  unsigned int repeat = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--books") {
+      bookCount = std::stoull(argv[i + 1]);
+    } else if (arg == "--seed") {
+      seed = std::stoull(argv[i + 1]);
+    } else if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--repeat") {
+      repeat = std::stoul(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (argc % 2 == 0 || repeat == 0) {
+    printUsage();
+    return 1;
+  }
+
+  // Random books, a batch of them to an order book at a time
+  const std::uint64_t batchSize = 10000;
+  const std::string products[] = {"BTC/USDT", "ETH/BTC", "DOGE/BTC"};
+  std::mt19937_64 random{seed};
+  Totals randomTotals;
+  for (std::uint64_t done = 0; done < bookCount; done += batchSize) {
+    OrderBook orderBook;
+    std::vector<std::pair<std::string, std::string>> books;
+    for (std::uint64_t b = done; b < bookCount && b < done + batchSize; b++) {
+      std::string timestamp = Timestamp::fromMicros(
+          std::int64_t(1590969600000000) + std::int64_t(b) * 1000);
+      const std::string &product = products[random() % 3];
+      // One side is sometimes empty
+      unsigned int asks = random() % 100 == 0 ? 0 : 1 + random() % 40;
+      unsigned int bids = random() % 100 == 0 ? 0 : 1 + random() % 40;
+      for (unsigned int i = 0; i < asks; i++) {
+        orderBook.insertOrder(
+            randomOrder(random, timestamp, product, OrderBookType::ask));
+      }
+      for (unsigned int i = 0; i < bids; i++) {
+        orderBook.insertOrder(
+            randomOrder(random, timestamp, product, OrderBookType::bid));
+      }
+      books.push_back({timestamp, product});
+    }
+    if (!matchBooks(orderBook, books, 1, randomTotals)) {
+      return 1;
+    }
+  }
+  if (bookCount > 0) {
+    printTotals("random", randomTotals);
+  }
+
+  // Every bucket of every product of a day file
+  if (!dataFile.empty()) {
+    OrderBook orderBook{dataFile};
+    std::vector<std::pair<std::string, std::string>> books;
+    std::vector<std::string> known = orderBook.getKnownProducts();
+    std::string earliest = orderBook.getEarliestTime();
+    std::string timestamp = earliest;
+    do {
+      for (const std::string &product : known) {
+        books.push_back({timestamp, product});
+      }
+      timestamp = orderBook.getNextTime(timestamp);
+    } while (timestamp != earliest);
+    Totals replayTotals;
+    if (!matchBooks(orderBook, books, repeat, replayTotals)) {
+      return 1;
+    }
+    printTotals("replayed", replayTotals);
+  }
+  return 0;
+}
@@ -0,0 +1,227 @@
+// Local stand-in exchange: replays a day file as a binary feed on a Unix
+// datagram socket, and takes orders from OrderGateway clients.
+//
+//   mock_exchange --data 20200601.csv --socket /tmp/merkel_feed.sock
+//                 [--bucket-interval-us 0] [--cpu N]
+//
+// The feed socket is bound by the client (FeedHandler); the exchange binds
+// SOCKET.orders for the orders sent back.
+
+#include "CSVReader.hpp"
+#include "FeedProtocol.hpp"
+#include "HostTuning.hpp"
+#include "OrderBookEntry.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+sockaddr_un socketAddress(const std::string &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  return address;
+}
+
+class FeedPublisher {
+public:
+  FeedPublisher(int _socketFd, const std::string &clientPath)
+      : socketFd(_socketFd), client(socketAddress(clientPath)), sequence(0),
+        messageCount(0), datagramCount(0) {}
+
+  void add(FeedMessage message) {
+    message.sequence = sequence++;
+    batch.push_back(message);
+    if (batch.size() == feedBatchSize) {
+      flush();
+    }
+  }
+
+  // The send time is stamped on the whole batch as it leaves
+  bool flush() {
+    if (batch.empty()) {
+      return true;
+    }
+    std::int64_t now = feedClockNanos();
+    for (FeedMessage &m : batch) {
+      m.sendTime = now;
+    }
+    std::size_t bytes = batch.size() * sizeof(FeedMessage);
+    // Until the client has bound its socket there is nobody to send to
+    for (int attempt = 0; attempt < 300; attempt++) {
+      if (::sendto(socketFd, batch.data(), bytes, 0,
+                   reinterpret_cast<const sockaddr *>(&client),
+                   sizeof(client)) == static_cast<ssize_t>(bytes)) {
+        messageCount += batch.size();
+        datagramCount++;
+        batch.clear();
+        return true;
+      }
+      if (errno != ENOENT && errno != ECONNREFUSED && errno != EAGAIN) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::cout << "mock_exchange cannot reach the feed client: "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  std::uint64_t getMessageCount() const { return messageCount; }
+  std::uint64_t getDatagramCount() const { return datagramCount; }
+
+private:
+  int socketFd;
+  sockaddr_un client;
+  std::vector<FeedMessage> batch;
+  std::uint32_t sequence;
+  std::uint64_t messageCount;
+  std::uint64_t datagramCount;
+};
+
+// Orders from the gateways are counted; products they announce are ignored
+unsigned int drainOrders(int orderFd) {
+  unsigned int orders = 0;
+  FeedMessage message;
+  while (::recv(orderFd, &message, sizeof(message), MSG_DONTWAIT) ==
+         sizeof(message)) {
+    if (message.type == FeedMessageType::newOrder) {
+      orders++;
+    }
+  }
+  return orders;
+}
+
+void printUsage() {
+  std::cout << "Usage: mock_exchange --data FILE --socket PATH "
+               "[--bucket-interval-us N] [--cpu N]"
+            << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  std::string socketPath;
+  long bucketIntervalMicros = 0;
+  int cpu = -1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--socket") {
+      socketPath = argv[i + 1];
+    } else if (arg == "--bucket-interval-us") {
+      bucketIntervalMicros = std::stol(argv[i + 1]);
+    } else if (arg == "--cpu") {
+      cpu = std::stoi(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (dataFile.empty() || socketPath.empty()) {
+    printUsage();
+    return 1;
+  }
+  // Keeps the publisher off the bot's core when both are pinned
+  if (!HostTuning::pinCurrentThread(cpu)) {
+    std::cout << "mock_exchange cannot pin to cpu " << cpu << std::endl;
+  }
+
+  std::map<std::string, std::vector<OrderBookEntry>> buckets =
+      CSVReader::readCSVMap(dataFile);
+
+  int feedFd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+  int orderFd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  std::string orderPath = socketPath + ".orders";
+  sockaddr_un orderAddress = socketAddress(orderPath);
+  ::unlink(orderPath.c_str());
+  if (feedFd < 0 || orderFd < 0 ||
+      ::bind(orderFd, reinterpret_cast<sockaddr *>(&orderAddress),
+             sizeof(orderAddress)) < 0) {
+    std::cout << "mock_exchange cannot open its sockets" << std::endl;
+    return 1;
+  }
+
+  FeedPublisher publisher{feedFd, socketPath};
+  std::map<std::string, std::uint16_t> productIds;
+  unsigned int ordersReceived = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  for (auto const &bucket : buckets) {
+    std::int64_t micros;
+    try {
+      micros = Timestamp::toMicros(bucket.first);
+    } catch (const std::exception &e) {
+      std::cout << "mock_exchange bad timestamp " << bucket.first << std::endl;
+      continue;
+    }
+    for (const OrderBookEntry &e : bucket.second) {
+      FeedMessage message{};
+      auto product = productIds.find(e.product);
+      if (product == productIds.end()) {
+        message.type = FeedMessageType::product;
+        message.productId = productIds.size();
+        std::memcpy(message.body.symbol, e.product.data(),
+                    std::min(e.product.size(), sizeof(message.body.symbol)));
+        product = productIds.emplace(e.product, message.productId).first;
+        publisher.add(message);
+        message = FeedMessage{};
+      }
+      message.type = FeedMessageType::order;
+      message.side = static_cast<std::uint8_t>(e.orderType);
+      message.productId = product->second;
+      message.timestamp = micros;
+      message.body.order = FeedOrder{e.price, e.amount};
+      publisher.add(message);
+    }
+    FeedMessage end{};
+    end.type = FeedMessageType::endOfBucket;
+    end.timestamp = micros;
+    publisher.add(end);
+    if (!publisher.flush()) {
+      return 1;
+    }
+    ordersReceived += drainOrders(orderFd);
+    if (bucketIntervalMicros > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(bucketIntervalMicros));
+    }
+  }
+  FeedMessage end{};
+  end.type = FeedMessageType::endOfFeed;
+  publisher.add(end);
+  publisher.flush();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  // Give the last decisions a moment to arrive
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ordersReceived += drainOrders(orderFd);
+
+  std::cout << "mock_exchange sent " << publisher.getMessageCount()
+            << " messages in " << publisher.getDatagramCount()
+            << " datagrams over " << buckets.size() << " buckets in "
+            << seconds << "s (" << publisher.getMessageCount() / seconds
+            << " msg/s)" << std::endl;
+  std::cout << "mock_exchange received " << ordersReceived << " orders"
+            << std::endl;
+  ::close(feedFd);
+  ::close(orderFd);
+  ::unlink(orderPath.c_str());
+  return 0;
+}
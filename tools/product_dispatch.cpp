@@ -0,0 +1,116 @@
+// Times the product parameters a trading decision needs, looked up the way
+// the bot used to (comparing the entry's product against string literals on
+// every call) and through the ProductId table of ProductRegistry.hpp.
+//
+//   product_dispatch --data 20200601.csv [--repeat 100]
+
+#include "CSVReader.hpp"
+#include "OrderBookEntry.hpp"
+#include "ProductRegistry.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: product_dispatch --data FILE [--repeat R]"
+            << std::endl;
+}
+
+// The bot's old string dispatch: deal size and both thresholds per decision
+double legacyDealSize(const std::string &product) {
+  if (product == "BTC/USDT") {
+    return 1;
+  }
+  if (product == "ETH/BTC") {
+    return 10;
+  }
+  if (product == "DOGE/BTC") {
+    return 100;
+  }
+  return 0;
+}
+
+double legacyDelta(const std::string &product, bool bid) {
+  if (product == "BTC/USDT") {
+    return bid ? 0.2 : -0.2;
+  }
+  if (product == "ETH/BTC") {
+    return bid ? 8.44151e-06 : -5.0012e-06;
+  }
+  if (product == "DOGE/BTC") {
+    return bid ? 0.001 : -0.001;
+  }
+  return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  unsigned int repeat = 100;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--repeat") {
+      repeat = std::stoul(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (dataFile.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  std::vector<OrderBookEntry> entries = CSVReader::readCSV(dataFile);
+  // Ids are resolved once, the way the bot resolves its ProductConfig
+  std::vector<ProductId> ids;
+  for (const OrderBookEntry &e : entries) {
+    ids.push_back(productForSymbol(e.product));
+  }
+
+  double legacySum = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (const OrderBookEntry &e : entries) {
+      legacySum += legacyDealSize(e.product) + legacyDelta(e.product, true) +
+                   legacyDelta(e.product, false);
+    }
+  }
+  double legacySeconds = secondsSince(start);
+
+  double tableSum = 0;
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (ProductId id : ids) {
+      if (isKnownProduct(id)) {
+        const ProductSpec &spec = productSpec(id);
+        tableSum += spec.dealSize + spec.bidDelta + spec.askDelta;
+      }
+    }
+  }
+  double tableSeconds = secondsSince(start);
+
+  double decisions = double(entries.size()) * repeat;
+  std::cout << decisions << " decisions" << std::endl;
+  std::cout << "string dispatch: " << legacySeconds / decisions * 1e9
+            << " ns per decision" << std::endl;
+  std::cout << "id table:        " << tableSeconds / decisions * 1e9
+            << " ns per decision" << std::endl;
+  // Both sums must agree, which also keeps the loops from being optimised away
+  std::cout << (legacySum == tableSum ? "same parameters" : "PARAMETERS DIFFER")
+            << std::endl;
+  return legacySum == tableSum ? 0 : 1;
+}
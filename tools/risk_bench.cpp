@@ -0,0 +1,152 @@
+// Times the pre-trade checks of RiskEngine against the rest of the decision
+// path: every bid of a day file goes through EMACrossoverStrategy::onTick,
+// once alone and once followed by a full risk check as if each tick sent
+// an order, with every limit switched on.
+//
+//   risk_bench --data 20200601.csv [--product BTC/USDT] [--repeat 200]
+
+#include "EMACrossoverStrategy.hpp"
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include "ProductConfig.hpp"
+#include "RiskEngine.hpp"
+#include "Timestamp.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: risk_bench --data FILE [--product SYMBOL] [--repeat R]"
+            << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Limits wide enough to let most orders through, so every check runs to
+// the end
+RiskLimits benchLimits(const ProductConfig &config) {
+  RiskLimits limits;
+  limits.maxPosition = config.dealSize * 1000;
+  limits.maxNotional = 1e12;
+  limits.maxOrders = 1000;
+  limits.windowMicros = 1000;
+  limits.priceBand = 0.5;
+  return limits;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  std::string product = "BTC/USDT";
+  unsigned int repeat = 200;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--product") {
+      product = argv[i + 1];
+    } else if (arg == "--repeat") {
+      repeat = std::stoul(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  ProductConfig config = ProductConfig::forProduct(product);
+  if (dataFile.empty() || !config.isValid()) {
+    printUsage();
+    return 1;
+  }
+
+  OrderBook orderBook{dataFile};
+  std::vector<OrderBookEntry> bids =
+      orderBook.getOrdersByTypeAndProduct(OrderBookType::bid, product);
+  // A feed hands the time over as a number, so it is not parsed per tick
+  std::vector<std::int64_t> micros;
+  for (const OrderBookEntry &e : bids) {
+    micros.push_back(Timestamp::toMicros(e.timestamp));
+  }
+  std::ostream discard{nullptr};
+
+  // The strategy alone
+  std::uint64_t actions = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    EMACrossoverStrategy strategy;
+    strategy.setup(config);
+    for (const OrderBookEntry &entry : bids) {
+      actions += strategy.onTick(entry, discard) != OrderBookType::unknown;
+    }
+  }
+  double strategySeconds = secondsSince(start);
+
+  // The strategy, then the checks of an order at every tick
+  std::uint64_t accepted = 0;
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    EMACrossoverStrategy strategy;
+    strategy.setup(config);
+    RiskEngine risk;
+    risk.setLimits(config.id, benchLimits(config));
+    for (std::size_t i = 0; i < bids.size(); i++) {
+      const OrderBookEntry &entry = bids[i];
+      OrderBookType action = strategy.onTick(entry, discard);
+      actions += action != OrderBookType::unknown;
+      OrderBookType side =
+          action == OrderBookType::unknown ? OrderBookType::bid : action;
+      risk.setReferencePrice(config.id, entry.price);
+      if (risk.check(config.id, side, entry.price, config.dealSize,
+                     micros[i]) == RiskResult::accepted) {
+        // Nothing fills here, every order closes as soon as it is sent
+        risk.onOrderSent(config.id, side, config.dealSize, micros[i]);
+        risk.onOrderClosed(config.id, side, config.dealSize);
+        accepted++;
+      }
+    }
+  }
+  double checkedSeconds = secondsSince(start);
+
+  // The checks alone
+  RiskEngine risk;
+  risk.setLimits(config.id, benchLimits(config));
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (std::size_t i = 0; i < bids.size(); i++) {
+      risk.setReferencePrice(config.id, bids[i].price);
+      OrderBookType side = i % 2 ? OrderBookType::bid : OrderBookType::ask;
+      if (risk.check(config.id, side, bids[i].price, config.dealSize,
+                     micros[i]) == RiskResult::accepted) {
+        risk.onOrderSent(config.id, side, config.dealSize, micros[i]);
+        risk.onOrderClosed(config.id, side, config.dealSize);
+        accepted++;
+      }
+    }
+  }
+  double riskSeconds = secondsSince(start);
+
+  double ticks = double(bids.size()) * repeat;
+  std::cout << ticks << " ticks of " << product << std::endl;
+  std::cout << "strategy:          " << strategySeconds / ticks * 1e9
+            << " ns per tick" << std::endl;
+  std::cout << "strategy + checks: " << checkedSeconds / ticks * 1e9
+            << " ns per tick (+"
+            << (checkedSeconds - strategySeconds) / strategySeconds * 100
+            << "%)" << std::endl;
+  std::cout << "checks alone:      " << riskSeconds / ticks * 1e9
+            << " ns per check" << std::endl;
+  // Printed so the loops cannot be optimised away
+  std::cout << actions << " actions, " << accepted << " orders accepted"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,124 @@
+// Reader of the bot's shared-memory book, and a benchmark of read throughput
+// while the bot is writing.
+//
+//   shm_book_reader --shm /merkelbook [--product BTC/USDT] [--seconds 5]
+//                   [--readers 1]
+//
+// Every reader thread reads the product's slot in a tight loop; once a
+// second the latest top-of-book is printed, and at the end the reads per
+// second, seqlock retries and failed reads of all readers. A read fails
+// when the slot stays mid-update, as when the bot stalls or dies during a
+// write; the monitor then prints the slot as stale.
+
+#include "SharedBookReader.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct ReaderResult {
+  std::uint64_t reads = 0;
+  std::uint64_t retries = 0;
+  std::uint64_t failed = 0;
+};
+
+void readLoop(const std::string &name, const std::string &product,
+              const std::atomic<bool> &stop, ReaderResult &result) {
+  SharedBookReader reader{name};
+  SharedBookSnapshot snapshot;
+  int index = -1;
+  while (!stop.load(std::memory_order_relaxed)) {
+    if (index < 0) {
+      index = reader.findProduct(product);
+      continue;
+    }
+    if (reader.read(index, snapshot)) {
+      result.reads++;
+    }
+  }
+  result.retries = reader.getRetryCount();
+  result.failed = reader.getFailedReadCount();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string name = "/merkelbook";
+  std::string product = "BTC/USDT";
+  int seconds = 5;
+  unsigned int readers = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--shm") {
+      name = argv[i + 1];
+    } else if (arg == "--product") {
+      product = argv[i + 1];
+    } else if (arg == "--seconds") {
+      seconds = std::stoi(argv[i + 1]);
+    } else if (arg == "--readers") {
+      readers = std::stoul(argv[i + 1]);
+    } else {
+      std::cout << "Usage: shm_book_reader --shm NAME [--product P] "
+                   "[--seconds N] [--readers N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // The bot may not have created the segment yet
+  std::unique_ptr<SharedBookReader> monitor{new SharedBookReader{name}};
+  for (int i = 0; i < 50 && !monitor->isOpen(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    monitor.reset(new SharedBookReader{name});
+  }
+  if (!monitor->isOpen()) {
+    std::cout << "shm_book_reader cannot open " << name << std::endl;
+    return 1;
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<ReaderResult> results(readers);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < readers; i++) {
+    threads.emplace_back(readLoop, name, product, std::cref(stop),
+                         std::ref(results[i]));
+  }
+
+  for (int s = 0; s < seconds; s++) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    int index = monitor->findProduct(product);
+    SharedBookSnapshot snapshot;
+    if (index < 0) {
+      continue;
+    }
+    if (monitor->read(index, snapshot)) {
+      std::cout << snapshot.timestamp << " " << snapshot.product
+                << " bid: " << snapshot.maxBid << " ask: " << snapshot.minAsk
+                << " levels: " << snapshot.bidLevels << "/"
+                << snapshot.askLevels << " updates: " << snapshot.updates
+                << std::endl;
+    } else {
+      std::cout << product << " stale: the slot stayed mid-update"
+                << std::endl;
+    }
+  }
+  stop.store(true);
+  std::uint64_t reads = 0;
+  std::uint64_t retries = 0;
+  std::uint64_t failed = 0;
+  for (unsigned int i = 0; i < readers; i++) {
+    threads[i].join();
+    reads += results[i].reads;
+    retries += results[i].retries;
+    failed += results[i].failed;
+  }
+  std::cout << "shm_book_reader " << readers << " readers: "
+            << reads / static_cast<double>(seconds) << " reads/s, " << retries
+            << " retries, " << failed << " failed reads" << std::endl;
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+// Wallet settlement throughput: the fills of every match of a day file
+// applied one at a time with Wallet::processSale, against the same fills
+// gathered into a WalletTransaction and applied with one Wallet::commit per
+// match. The fills are matched once, before the timing, and settled
+// --repeat times. Both wallets start with enough of every currency for
+// every commit to be accepted, so they must end with the same balances.
+//
+//   wallet_bench --data 20200601.csv [--repeat 20]
+
+#include "CSVReader.hpp"
+#include "OrderBook.hpp"
+#include "OrderBookEntry.hpp"
+#include "Wallet.hpp"
+#include "WalletTransaction.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: wallet_bench --data FILE [--repeat R]" << std::endl;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Every currency of the products, with more than the day can spend
+void fund(Wallet &wallet, const std::vector<std::string> &products) {
+  for (const std::string &product : products) {
+    for (const std::string &currency : CSVReader::tokenise(product, '/')) {
+      if (!wallet.containsCurrency(currency, 1)) {
+        wallet.insertCurrency(currency, 1e12);
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string dataFile;
+  unsigned int repeat = 20;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--data") {
+      dataFile = argv[i + 1];
+    } else if (arg == "--repeat") {
+      repeat = std::stoul(argv[i + 1]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (dataFile.empty() || repeat == 0) {
+    printUsage();
+    return 1;
+  }
+
+  // The fills of every product of every timestamp, one vector per match
+  OrderBook orderBook{dataFile};
+  std::vector<std::string> products = orderBook.getKnownProducts();
+  std::vector<std::vector<OrderBookEntry>> matches;
+  std::uint64_t fills = 0;
+  std::string earliest = orderBook.getEarliestTime();
+  std::string timestamp = earliest;
+  do {
+    for (const std::string &product : products) {
+      std::vector<OrderBookEntry> sales =
+          orderBook.matchAsksToBids(product, timestamp);
+      if (!sales.empty()) {
+        fills += sales.size();
+        matches.push_back(std::move(sales));
+      }
+    }
+    timestamp = orderBook.getNextTime(timestamp);
+  } while (timestamp != earliest);
+
+  // One fill at a time
+  Wallet perFill;
+  fund(perFill, products);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (std::vector<OrderBookEntry> &sales : matches) {
+      for (OrderBookEntry &sale : sales) {
+        perFill.processSale(sale);
+      }
+    }
+  }
+  double perFillSeconds = secondsSince(start);
+
+  // One commit per match
+  Wallet batched;
+  fund(batched, products);
+  std::uint64_t rejected = 0;
+  start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeat; r++) {
+    for (const std::vector<OrderBookEntry> &sales : matches) {
+      WalletTransaction transaction;
+      for (const OrderBookEntry &sale : sales) {
+        transaction.addSale(sale);
+      }
+      if (!batched.commit(transaction)) {
+        rejected++;
+      }
+    }
+  }
+  double batchedSeconds = secondsSince(start);
+
+  // The sums run in a different order, so they may differ in the last bits
+  double largestDifference = 0;
+  for (const auto &balance : perFill.getBalances()) {
+    auto other = batched.getBalances().find(balance.first);
+    double difference = other == batched.getBalances().end()
+                            ? std::fabs(balance.second)
+                            : std::fabs(balance.second - other->second);
+    largestDifference = std::fmax(largestDifference, difference / 1e12);
+  }
+
+  std::cout << matches.size() * repeat << " matches, " << fills * repeat
+            << " fills" << std::endl;
+  std::cout << "processSale per fill: " << fills * repeat / perFillSeconds
+            << " fills/s" << std::endl;
+  std::cout << "commit per match:     " << fills * repeat / batchedSeconds
+            << " fills/s (" << perFillSeconds / batchedSeconds << "x)"
+            << std::endl;
+  std::cout << "largest relative balance difference: " << largestDifference
+            << std::endl;
+  if (rejected > 0 || largestDifference > 1e-9) {
+    std::cout << rejected << " commits rejected, the wallets disagree"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}